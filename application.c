@@ -11,6 +11,8 @@
 #include "http.h"
 #include "io.h"
 #include "io_gpio.h"
+#include "io_mcp.h"
+#include "io_sim.h"
 #include "time.h"
 
 #include "ota.h"
@@ -42,14 +44,11 @@ static wlan_scan_state_t wlan_scan_state = ws_inactive;
 irom app_action_t application_content(const string_t *src, string_t *dst)
 {
 	const application_function_table_t *tableptr;
-	int status_io, status_pin;
+	const config_runtime_t *runtime = config_runtime_get();
+	app_action_t action;
 
-	if(config_get_int("trigger.status.io", -1, -1, &status_io) &&
-			config_get_int("trigger.status.pin", -1, -1, &status_pin) &&
-			(status_io != -1) && (status_pin != -1))
-	{
-		io_trigger_pin((string_t *)0, status_io, status_pin, io_trigger_on);
-	}
+	if((runtime->trigger_status_io != -1) && (runtime->trigger_status_pin != -1))
+		io_trigger_pin((string_t *)0, runtime->trigger_status_io, runtime->trigger_status_pin, io_trigger_on);
 
 	if(parse_string(0, src, dst) != parse_ok)
 		return(app_action_empty);
@@ -62,7 +61,13 @@ irom app_action_t application_content(const string_t *src, string_t *dst)
 	if(tableptr->function)
 	{
 		string_clear(dst);
-		return(tableptr->function(src, dst));
+		action = tableptr->function(src, dst);
+
+		// outputs changed by the command are written out at once
+
+		io_flush((string_t *)0);
+
+		return(action);
 	}
 
 	string_cat(dst, ": command unknown\n");
@@ -89,6 +94,33 @@ irom static app_action_t application_function_config_write(const string_t *src,
 	return(app_action_normal);
 }
 
+irom static app_action_t application_function_config_export(const string_t *src, string_t *dst)
+{
+	config_export(dst);
+	return(app_action_normal);
+}
+
+irom static app_action_t application_function_config_import(const string_t *src, string_t *dst)
+{
+	unsigned int imported;
+	int offset;
+
+	if((offset = string_sep(src, 0, 1, ' ')) < 0)
+	{
+		string_cat(dst, "> usage: config-import <id>=<value>, one per line, as from config-export\n");
+		return(app_action_error);
+	}
+
+	if(!config_import(src, offset, &imported))
+	{
+		string_format(dst, "> failed after %u entries\n", imported);
+		return(app_action_error);
+	}
+
+	string_format(dst, "> config import done, %u entries, use config-write to store\n", imported);
+	return(app_action_normal);
+}
+
 irom static app_action_t application_function_config_query_int(const string_t *src, string_t *dst)
 {
 	int index1, index2;
@@ -727,9 +759,9 @@ irom static app_action_t application_function_i2c_sensor_calibrate(const string_
 		int_offset = 0;
 
 	string_format(dst, "> i2c sensor %u/%u calibration set to factor ", bus, (int)sensor);
-	string_double(dst, int_factor / 1000.0, 4, 1e10);
+	string_fixed(dst, int_factor * 10, 4);
 	string_cat(dst, ", offset: ");
-	string_double(dst, int_offset / 1000.0, 4, 1e10);
+	string_fixed(dst, int_offset * 10, 4);
 	string_cat(dst, "\n");
 
 	return(app_action_normal);
@@ -1234,6 +1266,36 @@ irom static app_action_t application_function_gpio_assoc_set(const string_t *src
 	return(app_action_normal);
 }
 
+irom static app_action_t application_function_gpio_mcp_interrupt(const string_t *src, string_t *dst)
+{
+	int int_pin;
+
+	if(parse_int(1, src, &int_pin, 0) == parse_ok)
+	{
+		if((int_pin < -1) || ((int_pin >= 0) && !io_gpio_input_digital(int_pin)))
+		{
+			string_format(dst, "mcp interrupt gpio %d invalid, it must be a gpio in inputd mode\n", int_pin);
+			return(app_action_error);
+		}
+
+		if(int_pin < 0)
+			config_delete("mcp.%u.int.pin", io_mcp_instance_20, -1, false);
+		else
+			if(!config_set_int("mcp.%u.int.pin", io_mcp_instance_20, -1, int_pin))
+			{
+				string_cat(dst, "> cannot set config\n");
+				return(app_action_error);
+			}
+	}
+
+	if(!config_get_int("mcp.%u.int.pin", io_mcp_instance_20, -1, &int_pin))
+		int_pin = -1;
+
+	string_format(dst, "mcp interrupt at gpio %d (-1 is disabled, active after reset)\n", int_pin);
+
+	return(app_action_normal);
+}
+
 static const application_function_table_t application_function_table[] =
 {
 	{
@@ -1286,6 +1348,16 @@ static const application_function_table_t application_function_table[] =
 		application_function_config_write,
 		"write config to non-volatile storage"
 	},
+	{
+		"cex", "config-export",
+		application_function_config_export,
+		"export config in text format"
+	},
+	{
+		"cim", "config-import",
+		application_function_config_import,
+		"merge id=value lines from config-export (the old config sector is only imported once, at boot)"
+	},
 	{
 		"db", "display-brightness",
 		application_function_display_brightness,
@@ -1321,6 +1393,26 @@ static const application_function_table_t application_function_table[] =
 		application_function_gpio_status_set,
 		"set gpio to trigger on status update"
 	},
+	{
+		"gmi", "gpio-mcp-interrupt",
+		application_function_gpio_mcp_interrupt,
+		"set gpio connected to mcp23017 interrupt output"
+	},
+	{
+		"gsq", "gpio-sequence",
+		application_function_gpio_sequence,
+		"load, start and stop gpio output sequence playback"
+	},
+	{
+		"gsd", "gpio-sigma-delta",
+		application_function_gpio_sigma_delta,
+		"set gpio sigma-delta modulator prescale",
+	},
+	{
+		"gf", "gpio-fade",
+		application_function_gpio_fade,
+		"fade gpio pwm output to level (gamma corrected)",
+	},
 	{
 		"i2a", "i2c-address",
 		application_function_i2c_address,
@@ -1356,6 +1448,11 @@ static const application_function_table_t application_function_table[] =
 		application_function_io_write,
 		"write to i/o pin",
 	},
+	{
+		"ism", "io-sim-input",
+		application_function_io_sim_input,
+		"set simulated i/o input pin",
+	},
 	{
 		"isf", "io-set-flag",
 		application_function_io_set_flag,
@@ -1371,6 +1468,11 @@ static const application_function_table_t application_function_table[] =
 		application_function_io_clear_flag,
 		"clear i/o pin flag",
 	},
+	{
+		"ie", "io-events",
+		application_function_io_events,
+		"show i/o input change and counter events since <sequence>",
+	},
 	{
 		"isi", "i2c-sensor-init",
 		application_function_i2c_sensor_init,
@@ -10,34 +10,132 @@
 #include <spi_flash.h>
 
 #define CONFIG_MAGIC "%4afc0002%\n"
+#define CONFIG_BLOB_PREFIX "blob:"
 
 enum
 {
 	config_entries_size = 100,
-	config_entry_id_size = 28,
-	config_entry_string_size = 32
+	config_id_size = 64,
+	config_value_size = 256,
+	config_arena_size = 3072,
+	config_index_size = 128,
+	config_log_magic = 0x4afc0104,
+	config_log_version = 3,
+	config_log_sectors_size = USER_CONFIG_LOG_SECTORS,
 };
 
+typedef enum attr_packed
+{
+	config_log_record_set = 0x01,
+	config_log_record_set_int = 0x02,
+	config_log_record_set_blob = 0x03,
+	config_log_record_erased = 0xff,
+} config_log_record_type_t;
+
+assert_size(config_log_record_type_t, 1);
+
 typedef struct
 {
-	char	id[config_entry_id_size];
-	char	string_value[config_entry_string_size];
-	int		int_value;
+	uint32_t	magic;
+	uint16_t	version;
+	uint16_t	entries;	// records in the image
+	uint32_t	sequence;
+	uint32_t	length;		// image length, log records are appended after the image
+	uint32_t	crc;		// image crc
+} config_log_header_t;
+
+assert_size(config_log_header_t, 20);
+
+typedef struct attr_packed
+{
+	uint32_t					crc;
+	config_log_record_type_t	type;
+	uint8_t						id_length;
+	uint8_t						value_length;
+	uint8_t						spare;
+	int32_t						int_value;
+} config_log_record_t;
+
+assert_size(config_log_record_t, 12);
+
+static struct
+{
+	unsigned int	sector;
+	unsigned int	offset;
+	uint32_t		sequence;
+	unsigned int	valid:1;
+	unsigned int	compact:1;
+} config_log;
+
+_Static_assert((config_index_size & (config_index_size - 1)) == 0, "config_index_size not a power of 2");
+_Static_assert(config_index_size > config_entries_size, "config_index_size too small");
+_Static_assert(config_log_sectors_size >= 2, "compaction needs a spare config log sector");
+
+enum
+{
+	config_entry_flag_string = 1 << 0,
+	config_entry_flag_dirty = 1 << 1,
+	config_entry_flag_blob = 1 << 2,
+};
+
+// variable length, followed by the nul terminated id and,
+// for string values, the nul terminated value
+
+typedef struct
+{
+	uint16_t	length;			// including header and padding, multiple of 4
+	uint8_t		flags;
+	uint8_t		value_offset;	// from start of id
+	int32_t		int_value;
+	char		id[];
 } config_entry_t;
 
-assert_size(config_entry_t, 64);
+assert_size(config_entry_t, 8);
 
 static unsigned int config_entries_length = 0;
-static config_entry_t config_entries[config_entries_size];
-
-irom config_flags_t config_flags_get(void)
+static unsigned int config_arena_length = 0;
+static uint32_t config_arena[config_arena_size / sizeof(uint32_t)];
+static uint16_t config_index[config_index_size]; // arena offset / 4 + 1, 0 = free
+static unsigned int config_generation = 1;
+static unsigned int config_runtime_generation = 0;
+static config_runtime_t config_runtime;
+
+irom const config_runtime_t *config_runtime_get(void)
 {
-	config_flags_t flags;
+	if(config_runtime_generation == config_generation)
+		return(&config_runtime);
+
+	if(!config_get_int("flags", -1, -1, &config_runtime.flags.intval))
+		config_runtime.flags.intval = 0;
+
+	if(!config_get_int("pwm.period", -1, -1, &config_runtime.pwm_period))
+		config_runtime.pwm_period = 65536;
+
+	if(!config_get_int("display.fliptimeout", -1, -1, &config_runtime.display_fliptimeout))
+		config_runtime.display_fliptimeout = 4;
 
-	if(!config_get_int("flags", -1, -1, &flags.intval))
-		flags.intval = 0;
+	if(!config_get_int("trigger.status.io", -1, -1, &config_runtime.trigger_status_io) ||
+			!config_get_int("trigger.status.pin", -1, -1, &config_runtime.trigger_status_pin))
+	{
+		config_runtime.trigger_status_io = -1;
+		config_runtime.trigger_status_pin = -1;
+	}
+
+	if(!config_get_int("trigger.assoc.io", -1, -1, &config_runtime.trigger_assoc_io) ||
+			!config_get_int("trigger.assoc.pin", -1, -1, &config_runtime.trigger_assoc_pin))
+	{
+		config_runtime.trigger_assoc_io = -1;
+		config_runtime.trigger_assoc_pin = -1;
+	}
+
+	config_runtime_generation = config_generation;
 
-	return(flags);
+	return(&config_runtime);
+}
+
+irom config_flags_t config_flags_get(void)
+{
+	return(config_runtime_get()->flags);
 }
 
 irom bool_t config_flags_set(config_flags_t flags)
@@ -156,30 +254,113 @@ typedef enum
 	state_parse_eol,
 } state_parse_t;
 
-irom static string_t *expand_varid(const char *id, int index1, int index2)
+irom static const char *expand_varid(const char *id, int index1, int index2)
 {
 	string_new(static, varid, 64);
+	const char *src;
+
+	for(src = id; *src; src++)
+		if(*src == '%')
+			break;
+
+	if(!*src)
+		return(id);
 
 	string_clear(&varid);
 	string_format_data(&varid, id, index1, index2);
 
-	return(&varid);
+	return(string_to_const_ptr(&varid));
+}
+
+irom attr_pure static unsigned int hash_varid(const char *varid)
+{
+	unsigned int hash;
+
+	// FNV-1a
+
+	for(hash = 2166136261U; *varid; varid++)
+	{
+		hash ^= (uint8_t)*varid;
+		hash *= 16777619U;
+	}
+
+	return(hash & (config_index_size - 1));
+}
+
+irom static config_entry_t *config_entry_at(unsigned int offset)
+{
+	return((config_entry_t *)&config_arena[offset / sizeof(uint32_t)]);
 }
 
-irom static config_entry_t *find_config_entry(const char *id, int index1, int index2)
+irom static const char *config_entry_value(const config_entry_t *entry)
+{
+	return(&entry->id[entry->value_offset]);
+}
+
+irom static void config_entry_format_value(string_t *dst, const config_entry_t *entry)
+{
+	if(entry->flags & config_entry_flag_string)
+		string_format(dst, "%s", config_entry_value(entry));
+	else
+		if(entry->flags & config_entry_flag_blob)
+			string_bin_to_hex(dst, config_entry_value(entry), entry->int_value);
+	else
+		string_format(dst, "%d", entry->int_value);
+}
+
+irom static void config_index_add(unsigned int offset)
+{
+	unsigned int slot;
+
+	for(slot = hash_varid(config_entry_at(offset)->id); config_index[slot]; slot = (slot + 1) & (config_index_size - 1))
+		;
+
+	config_index[slot] = (offset / sizeof(uint32_t)) + 1;
+}
+
+irom static void config_index_rebuild(void)
+{
+	unsigned int offset;
+
+	memset(config_index, 0, sizeof(config_index));
+
+	for(offset = 0; offset < config_arena_length; offset += config_entry_at(offset)->length)
+		config_index_add(offset);
+}
+
+irom static void config_arena_clear(void)
+{
+	config_entries_length = 0;
+	config_arena_length = 0;
+	config_index_rebuild();
+}
+
+irom static void config_arena_clean(void)
+{
+	unsigned int offset;
+
+	for(offset = 0; offset < config_arena_length; offset += config_entry_at(offset)->length)
+		config_entry_at(offset)->flags &= ~config_entry_flag_dirty;
+}
+
+irom static config_entry_t *find_config_entry(const char *varid)
 {
 	config_entry_t *config_entry;
-	const string_t *varid;
-	unsigned int ix;
+	unsigned int slot, probe, entry;
 
-	varid = expand_varid(id, index1, index2);
+	slot = hash_varid(varid);
 
-	for(ix = 0; ix < config_entries_length; ix++)
+	for(probe = 0; probe < config_index_size; probe++)
 	{
-		config_entry = &config_entries[ix];
+		if(!(entry = config_index[slot]))
+			break;
 
-		if(string_match(varid, config_entry->id))
+		config_entry = config_entry_at((entry - 1) * sizeof(uint32_t));
+
+		if(!strcmp(config_entry->id, varid))
 			return(config_entry);
+
+		slot = (slot + 1) & (config_index_size - 1);
 	}
 
 	return((config_entry_t *)0);
@@ -189,10 +370,10 @@ irom bool_t config_get_string(const char *id, int index1, int index2, string_t *
 {
 	config_entry_t *config_entry;
 
-	if(!(config_entry = find_config_entry(id, index1, index2)))
+	if(!(config_entry = find_config_entry(expand_varid(id, index1, index2))))
 		return(false);
 
-	string_format(value, "%s", config_entry->string_value);
+	config_entry_format_value(value, config_entry);
 
 	return(true);
 }
@@ -201,7 +382,10 @@ irom bool_t config_get_int(const char *id, int index1, int index2, int *value)
 {
 	config_entry_t *config_entry;
 
-	if(!(config_entry = find_config_entry(id, index1, index2)))
+	if(!(config_entry = find_config_entry(expand_varid(id, index1, index2))))
+		return(false);
+
+	if(config_entry->flags & config_entry_flag_blob)
 		return(false);
 
 	*value = config_entry->int_value;
@@ -209,12 +393,115 @@ irom bool_t config_get_int(const char *id, int index1, int index2, int *value)
 	return(true);
 }
 
-irom bool_t config_set_string(const char *id, int index1, int index2, const string_t *value, int value_offset, int value_length)
+irom static void config_arena_remove(config_entry_t *entry)
+{
+	unsigned int offset, length;
+
+	offset = (uint32_t *)entry - config_arena;
+	offset *= sizeof(uint32_t);
+	length = entry->length;
+
+	memmove(config_entry_at(offset), config_entry_at(offset + length), config_arena_length - offset - length);
+
+	config_arena_length -= length;
+	config_entries_length--;
+}
+
+irom static unsigned int config_entry_length(unsigned int id_length, unsigned int value_length, unsigned int type)
+{
+	unsigned int length;
+
+	length = sizeof(config_entry_t) + id_length + 1;
+
+	if(type & config_entry_flag_string)
+		length += value_length + 1;
+
+	if(type & config_entry_flag_blob)
+		length += value_length;
+
+	return((length + (sizeof(uint32_t) - 1)) & ~(sizeof(uint32_t) - 1));
+}
+
+irom static config_entry_t *config_arena_append(const char *varid, int id_length, const char *value, int value_length, int int_value, unsigned int type)
+{
+	config_entry_t *entry;
+	unsigned int length;
+
+	length = config_entry_length(id_length, value_length, type);
+
+	if(((config_entries_length + 1) >= config_entries_size) || ((config_arena_length + length) > config_arena_size))
+		return((config_entry_t *)0);
+
+	entry = config_entry_at(config_arena_length);
+
+	entry->length = length;
+	entry->flags = type;
+	entry->value_offset = id_length + 1;
+	entry->int_value = int_value;
+
+	memcpy(entry->id, varid, id_length);
+	entry->id[id_length] = '\0';
+
+	if(type & config_entry_flag_string)
+	{
+		memcpy(&entry->id[entry->value_offset], value, value_length);
+		entry->id[entry->value_offset + value_length] = '\0';
+	}
+
+	if(type & config_entry_flag_blob)
+		memcpy(&entry->id[entry->value_offset], value, value_length);
+
+	config_index_add(config_arena_length);
+
+	config_arena_length += length;
+	config_entries_length++;
+
+	return(entry);
+}
+
+irom static bool_t config_store(const char *varid, const char *value, int value_length, int int_value, unsigned int type)
 {
-	string_t string;
-	string_t *varid;
 	config_entry_t *config_current;
-	unsigned int ix;
+	unsigned int id_length, length;
+
+	if((id_length = strlen(varid)) >= config_id_size)
+		return(false);
+
+	if(value_length >= config_value_size)
+		return(false);
+
+	length = config_entry_length(id_length, value_length, type);
+
+	if((config_current = find_config_entry(varid)))
+	{
+		if((config_current->int_value == int_value) &&
+				((config_current->flags & (config_entry_flag_string | config_entry_flag_blob)) == type) &&
+				(!(type & config_entry_flag_string) || (!strncmp(config_entry_value(config_current), value, value_length) &&
+					!config_entry_value(config_current)[value_length])) &&
+				(!(type & config_entry_flag_blob) || !memcmp(config_entry_value(config_current), value, value_length)))
+			return(true);
+
+		if((config_arena_length - config_current->length + length) > config_arena_size)
+			return(false);
+
+		config_arena_remove(config_current);
+		config_index_rebuild();
+	}
+
+	if(!(config_current = config_arena_append(varid, id_length, value, value_length, int_value, type)))
+		return(false);
+
+	config_current->flags |= config_entry_flag_dirty;
+	config_generation++;
+
+	return(true);
+}
+
+irom bool_t config_set_string(const char *id, int index1, int index2, const string_t *value, int value_offset, int value_length)
+{
+	string_new(, string, config_value_size);
+	string_new(, int_string, 16);
+	int int_value;
 
 	if(value_offset >= string_length(value))
 		value_offset = string_length(value) - 1;
@@ -228,42 +515,23 @@ irom bool_t config_set_string(const char *id, int index1, int index2, const stri
 	if((value_offset + value_length) > string_length(value))
 		value_length = string_length(value) - value_offset;
 
-	if(value_length >= config_entry_string_size)
-		value_length = config_entry_string_size - 1;
-
 	if(value_length < 0)
 		value_length = 0;
 
-	if(!(config_current = find_config_entry(id, index1, index2)))
-	{
-		for(ix = 0; ix < config_entries_length; ix++)
-		{
-			config_current = &config_entries[ix];
-
-			if(!config_current->id[0])
-				break;
-		}
-
-		if(ix >= config_entries_length)
-		{
-			if((config_entries_length + 1) >= config_entries_size)
-				return(false);
-
-			config_current = &config_entries[config_entries_length++];
-		}
+	if(value_length >= config_value_size)
+		return(false);
 
-		varid = expand_varid(id, index1, index2);
-		strlcpy(config_current->id, string_to_const_ptr(varid), config_entry_string_size);
-	}
+	string_splice(&string, value, value_offset, value_length);
 
-	strlcpy(config_current->string_value, string_to_const_ptr(value) + value_offset, value_length + 1);
+	if(parse_int(0, &string, &int_value, 0) != parse_ok)
+		int_value = -1;
 
-	string = string_from_ptr(value_length + 1, config_current->string_value);
+	// store as plain int if the text representation is the canonical one
 
-	if(parse_int(0, &string, &config_current->int_value, 0) != parse_ok)
-		config_current->int_value = -1;
+	string_format(&int_string, "%d", int_value);
 
-	return(true);
+	return(config_store(expand_varid(id, index1, index2), string_to_const_ptr(&string), string_length(&string), int_value,
+				string_match_string(&string, &int_string) ? 0 : config_entry_flag_string));
 }
 
 irom bool_t config_set_int(const char *id, int index1, int index2, int value)
@@ -275,49 +543,67 @@ irom bool_t config_set_int(const char *id, int index1, int index2, int value)
 	return(config_set_string(id, index1, index2, &string, 0, -1));
 }
 
+irom bool_t config_get_blob(const char *id, int index1, int index2, void *value, int length)
+{
+	config_entry_t *config_entry;
+
+	if(!(config_entry = find_config_entry(expand_varid(id, index1, index2))))
+		return(false);
+
+	if(!(config_entry->flags & config_entry_flag_blob) || (config_entry->int_value != length))
+		return(false);
+
+	memcpy(value, config_entry_value(config_entry), length);
+
+	return(true);
+}
+
+irom bool_t config_set_blob(const char *id, int index1, int index2, const void *value, int length)
+{
+	return(config_store(expand_varid(id, index1, index2), value, length, length, config_entry_flag_blob));
+}
+
 irom unsigned int config_delete(const char *id, int index1, int index2, bool_t wildcard)
 {
 	const char *varidptr;
 	config_entry_t *config_current;
-	unsigned int ix;
+	unsigned int offset;
 	unsigned int amount, length;
 
-	varidptr = string_to_const_ptr(expand_varid(id, index1, index2));
+	varidptr = expand_varid(id, index1, index2);
 	length = strlen(varidptr);
 
-	for(ix = 0, amount = 0; ix < config_entries_length; ix++)
+	for(offset = 0, amount = 0; offset < config_arena_length;)
 	{
-		config_current = &config_entries[ix];
+		config_current = config_entry_at(offset);
 
 		if((wildcard && !strncmp(config_current->id, varidptr, length)) ||
 			(!wildcard && !strcmp(config_current->id, varidptr)))
 		{
 			amount++;
-			config_current->id[0] = '\0';
-			config_current->string_value[0] = '\0';
-			config_current->int_value = '0';
+			config_arena_remove(config_current);
 		}
+		else
+			offset += config_current->length;
+	}
+
+	if(amount)
+	{
+		config_index_rebuild();
+		config_generation++;
+		config_log.compact = 1;
 	}
 
 	return(amount);
 }
 
-irom bool_t config_read(void)
+irom static bool_t config_read_text(void)
 {
 	string_new(, string, 64);
 	int current_index, id_index, id_length, value_index, value_length;
 	char current;
 	state_parse_t parse_state;
 
-	if(ota_is_active())
-		return(false);
-
-	if(wlan_scan_active())
-		return(false);
-
-	if(string_size(&buffer_4k) < SPI_FLASH_SEC_SIZE)
-		return(false);
-
 	if(spi_flash_read(USER_CONFIG_SECTOR * SPI_FLASH_SEC_SIZE, string_to_ptr(&buffer_4k), SPI_FLASH_SEC_SIZE) != SPI_FLASH_RESULT_OK)
 		return(false);
 
@@ -337,8 +623,6 @@ irom bool_t config_read(void)
 	value_index = 0;
 	value_length = 0;
 
-	config_entries_length = 0;
-
 	for(parse_state = state_parse_id; current_index < SPI_FLASH_SEC_SIZE; current_index++)
 	{
 		current = string_index(&buffer_4k, current_index);
@@ -416,83 +700,453 @@ done:
 	return(true);
 }
 
-irom unsigned int config_write(void)
+irom static void config_log_render(string_t *dst, bool_t all)
 {
 	config_entry_t *entry;
-	unsigned int ix, length;
-	uint32_t crc1, crc2;
+	config_log_record_t record;
+	unsigned int entry_offset, offset, length;
+
+	for(entry_offset = 0; entry_offset < config_arena_length; entry_offset += entry->length)
+	{
+		entry = config_entry_at(entry_offset);
+
+		if(!all && !(entry->flags & config_entry_flag_dirty))
+			continue;
+
+		record.id_length = entry->value_offset - 1;
+
+		if(entry->flags & config_entry_flag_string)
+		{
+			record.type = config_log_record_set;
+			record.value_length = strlen(config_entry_value(entry));
+		}
+		else
+			if(entry->flags & config_entry_flag_blob)
+			{
+				record.type = config_log_record_set_blob;
+				record.value_length = entry->int_value;
+			}
+			else
+			{
+				record.type = config_log_record_set_int;
+				record.value_length = 0;
+			}
+
+		record.spare = 0;
+		record.int_value = entry->int_value;
+
+		offset = string_length(dst);
+		length = (sizeof(record) + record.id_length + record.value_length + 3) & ~3;
+
+		if((offset + length) > (unsigned int)string_size(dst))
+		{
+			string_setlength(dst, string_size(dst));
+			return;
+		}
+
+		memcpy(string_to_ptr(dst) + offset + sizeof(record), entry->id, record.id_length);
+		memcpy(string_to_ptr(dst) + offset + sizeof(record) + record.id_length, config_entry_value(entry), record.value_length);
+		memset(string_to_ptr(dst) + offset + sizeof(record) + record.id_length + record.value_length, 0xff,
+				length - sizeof(record) - record.id_length - record.value_length);
+		memcpy(string_to_ptr(dst) + offset, &record, sizeof(record));
+		string_setlength(dst, offset + length);
+
+		record.crc = string_crc32(dst, offset + sizeof(record.crc), length - sizeof(record.crc));
+		memcpy(string_to_ptr(dst) + offset, &record.crc, sizeof(record.crc));
+	}
+}
+
+irom static bool_t config_log_record_valid(const config_log_record_t *record)
+{
+	if((record->type != config_log_record_set) && (record->type != config_log_record_set_int) && (record->type != config_log_record_set_blob))
+		return(false);
+
+	if((record->id_length == 0) || (record->id_length >= config_id_size))
+		return(false);
+
+	if((record->type == config_log_record_set_int) && (record->value_length != 0))
+		return(false);
+
+	if((record->type == config_log_record_set_blob) && (record->int_value != record->value_length))
+		return(false);
+
+	return(true);
+}
+
+irom static unsigned int config_log_record_entry_type(unsigned int type)
+{
+	if(type == config_log_record_set)
+		return(config_entry_flag_string);
+
+	if(type == config_log_record_set_blob)
+		return(config_entry_flag_blob);
+
+	return(0);
+}
+
+irom static bool_t config_log_load(const config_log_header_t *header)
+{
+	string_new(, id, config_id_size);
+	config_log_record_t record;
+	const char *data;
+	unsigned int offset, length, ix;
+
+	if(spi_flash_read((USER_CONFIG_LOG_SECTOR + config_log.sector) * SPI_FLASH_SEC_SIZE, string_to_ptr(&buffer_4k), SPI_FLASH_SEC_SIZE) != SPI_FLASH_RESULT_OK)
+		return(false);
+
+	string_setlength(&buffer_4k, SPI_FLASH_SEC_SIZE);
+
+	if((header->entries >= config_entries_size) || (header->length > (SPI_FLASH_SEC_SIZE - sizeof(*header))) ||
+			(header->crc != string_crc32(&buffer_4k, sizeof(*header), header->length)))
+		return(false);
+
+	// the image is validated as a whole, copy it straight into the arena, it never contains duplicates
+
+	for(offset = sizeof(*header), ix = 0; ix < header->entries; ix++, offset += length)
+	{
+		memcpy(&record, string_to_const_ptr(&buffer_4k) + offset, sizeof(record));
+
+		if(!config_log_record_valid(&record))
+			return(false);
+
+		length = (sizeof(record) + record.id_length + record.value_length + 3) & ~3;
+		data = string_to_const_ptr(&buffer_4k) + offset + sizeof(record);
+
+		if(!config_arena_append(data, record.id_length, data + record.id_length, record.value_length,
+					record.int_value, config_log_record_entry_type(record.type)))
+			return(false);
+	}
+
+	// replay the records that have been appended since
+
+	for(offset = sizeof(*header) + header->length; (offset + sizeof(record)) <= SPI_FLASH_SEC_SIZE; offset += length)
+	{
+		memcpy(&record, string_to_const_ptr(&buffer_4k) + offset, sizeof(record));
+
+		// only a fully erased record header is the end of the log, the crc is programmed before the type
+
+		for(ix = 0; (ix < sizeof(record)) && (((const uint8_t *)&record)[ix] == 0xff); ix++)
+			;
+
+		if(ix == sizeof(record))
+			break;
+
+		length = (sizeof(record) + record.id_length + record.value_length + 3) & ~3;
+
+		// an incomplete record from an interrupted write ends the log, it can't be appended to anymore
+
+		if(!config_log_record_valid(&record) || ((offset + length) > SPI_FLASH_SEC_SIZE) ||
+				(record.crc != string_crc32(&buffer_4k, offset + sizeof(record.crc), length - sizeof(record.crc))))
+		{
+			config_log.compact = 1;
+			break;
+		}
+
+		string_clear(&id);
+		string_splice(&id, &buffer_4k, offset + sizeof(record), record.id_length);
+
+		config_store(string_to_const_ptr(&id), string_to_const_ptr(&buffer_4k) + offset + sizeof(record) + record.id_length,
+				record.value_length, record.int_value, config_log_record_entry_type(record.type));
+	}
+
+	config_log.offset = offset;
+
+	return(true);
+}
+
+irom bool_t config_read(void)
+{
+	config_log_header_t header, best_header = { .magic = 0 };
+	unsigned int sector, tried;
+	bool_t rv;
 
 	if(ota_is_active())
-		return(0);
+		return(false);
 
 	if(wlan_scan_active())
-		return(0);
+		return(false);
 
 	if(string_size(&buffer_4k) < SPI_FLASH_SEC_SIZE)
-		return(0);
+		return(false);
 
-	string_clear(&buffer_4k);
-	string_cat(&buffer_4k, CONFIG_MAGIC);
-	string_cat(&buffer_4k, "\n");
+	config_log.compact = 0;
+
+	// use the most recent sector with a valid image, fall back to older ones
 
-	for(ix = 0; ix < config_entries_length; ix++)
+	for(tried = 0, rv = false; !rv;)
 	{
-		entry = &config_entries[ix];
+		config_log.valid = 0;
 
-		if(!entry->id[0])
-			continue;
+		for(sector = 0; sector < config_log_sectors_size; sector++)
+		{
+			if(tried & (1 << sector))
+				continue;
+
+			if(spi_flash_read((USER_CONFIG_LOG_SECTOR + sector) * SPI_FLASH_SEC_SIZE, &header, sizeof(header)) != SPI_FLASH_RESULT_OK)
+				continue;
+
+			if((header.magic != config_log_magic) || (header.version < 1) || (header.version > config_log_version))
+				continue;
+
+			if(!config_log.valid || (header.sequence > best_header.sequence))
+			{
+				config_log.valid = 1;
+				config_log.sector = sector;
+				best_header = header;
+			}
+		}
+
+		if(!config_log.valid)
+			break;
+
+		tried |= 1 << config_log.sector;
+		config_log.sequence = best_header.sequence;
+
+		config_arena_clear();
 
-		string_format(&buffer_4k, "%s=%s\n", entry->id, entry->string_value);
+		if(!(rv = config_log_load(&best_header)))
+			config_log.compact = 1;
 	}
 
-	string_cat(&buffer_4k, "\n");
+	config_generation++;
+
+	if(!config_log.valid)
+	{
+		// no log yet, import old style text config, it will be converted on the next write
+
+		config_log.sequence = 0;
+		config_log.offset = 0;
+		config_log.sector = config_log_sectors_size - 1;
+		config_log.compact = 1;
+
+		config_arena_clear();
+
+		rv = config_read_text();
+	}
+
+	config_arena_clean();
+
+	return(rv);
+}
+
+irom static unsigned int config_log_compact(void)
+{
+	config_log_header_t header;
+	unsigned int sector, length;
+	uint32_t crc1, crc2;
+
+	sector = (config_log.sector + 1) % config_log_sectors_size;
+
+	string_clear(&buffer_4k);
+
+	while(string_length(&buffer_4k) < (int)sizeof(header))
+		string_append(&buffer_4k, 0xff);
+
+	config_log_render(&buffer_4k, true);
 
 	length = string_length(&buffer_4k);
 
-	if(length > (4096 - 32))
+	if(length >= SPI_FLASH_SEC_SIZE)
 		return(0);
 
-	while(string_length(&buffer_4k) < SPI_FLASH_SEC_SIZE)
-		string_append(&buffer_4k, '.');
-
-	string_crc32_init();
-	crc1 = string_crc32(&buffer_4k, 0, SPI_FLASH_SEC_SIZE);
+	crc1 = string_crc32(&buffer_4k, sizeof(header), length - sizeof(header));
 
-	if(spi_flash_erase_sector(USER_CONFIG_SECTOR) != SPI_FLASH_RESULT_OK)
+	if(spi_flash_erase_sector(USER_CONFIG_LOG_SECTOR + sector) != SPI_FLASH_RESULT_OK)
 		return(0);
 
-	if(spi_flash_write(USER_CONFIG_SECTOR * SPI_FLASH_SEC_SIZE, string_to_const_ptr(&buffer_4k), SPI_FLASH_SEC_SIZE) != SPI_FLASH_RESULT_OK)
+	// write the header last, so an interrupted compaction leaves the previous sector in charge
+
+	if(spi_flash_write((USER_CONFIG_LOG_SECTOR + sector) * SPI_FLASH_SEC_SIZE + sizeof(header),
+				string_to_const_ptr(&buffer_4k) + sizeof(header), length - sizeof(header)) != SPI_FLASH_RESULT_OK)
 		return(0);
 
-	if(spi_flash_read(USER_CONFIG_SECTOR * SPI_FLASH_SEC_SIZE, string_to_ptr(&buffer_4k), SPI_FLASH_SEC_SIZE) != SPI_FLASH_RESULT_OK)
+	if(spi_flash_read((USER_CONFIG_LOG_SECTOR + sector) * SPI_FLASH_SEC_SIZE, string_to_ptr(&buffer_4k), length) != SPI_FLASH_RESULT_OK)
 		return(0);
 
-	string_setlength(&buffer_4k, SPI_FLASH_SEC_SIZE);
+	string_setlength(&buffer_4k, length);
 
-	crc2 = string_crc32(&buffer_4k, 0, SPI_FLASH_SEC_SIZE);
+	crc2 = string_crc32(&buffer_4k, sizeof(header), length - sizeof(header));
 
 	if(crc1 != crc2)
 		return(0);
 
+	header.entries = config_entries_length;
+	header.magic = config_log_magic;
+	header.version = config_log_version;
+	header.sequence = config_log.sequence + 1;
+	header.length = length - sizeof(header);
+	header.crc = crc1;
+
+	if(spi_flash_write((USER_CONFIG_LOG_SECTOR + sector) * SPI_FLASH_SEC_SIZE, &header, sizeof(header)) != SPI_FLASH_RESULT_OK)
+		return(0);
+
+	config_log.valid = 1;
+	config_log.compact = 0;
+	config_log.sector = sector;
+	config_log.sequence = header.sequence;
+	config_log.offset = length;
+
 	return(length);
 }
 
-irom void config_dump(string_t *dst)
+irom unsigned int config_write(void)
 {
-	config_entry_t *config_current;
-	unsigned int ix, in_use = 0;
+	unsigned int length;
+	uint32_t crc1, crc2;
+
+	if(ota_is_active())
+		return(0);
+
+	if(wlan_scan_active())
+		return(0);
+
+	if(string_size(&buffer_4k) < SPI_FLASH_SEC_SIZE)
+		return(0);
+
+	string_clear(&buffer_4k);
+	config_log_render(&buffer_4k, false);
+	length = string_length(&buffer_4k);
+
+	if(!config_log.valid || config_log.compact || ((config_log.offset + length) > SPI_FLASH_SEC_SIZE))
+		length = config_log_compact();
+	else
+	{
+		if(length > 0)
+		{
+			crc1 = string_crc32(&buffer_4k, 0, length);
+
+			// from here on the sector can't be trusted to be appended to until it's verified
+
+			config_log.compact = 1;
+
+			if(spi_flash_write((USER_CONFIG_LOG_SECTOR + config_log.sector) * SPI_FLASH_SEC_SIZE + config_log.offset,
+						string_to_const_ptr(&buffer_4k), length) != SPI_FLASH_RESULT_OK)
+				return(0);
+
+			if(spi_flash_read((USER_CONFIG_LOG_SECTOR + config_log.sector) * SPI_FLASH_SEC_SIZE + config_log.offset,
+						string_to_ptr(&buffer_4k), length) != SPI_FLASH_RESULT_OK)
+				return(0);
+
+			string_setlength(&buffer_4k, length);
+
+			crc2 = string_crc32(&buffer_4k, 0, length);
+
+			if(crc1 != crc2)
+				return(0);
+
+			config_log.compact = 0;
+			config_log.offset += length;
+		}
+
+		length = config_log.offset;
+	}
+
+	if(length)
+		config_arena_clean();
+
+	return(length);
+}
+
+// merge id=value lines, as emitted by config_export, one per line, the magic line and empty lines are skipped
 
-	for(ix = 0; ix < config_entries_length; ix++)
+irom bool_t config_import(const string_t *src, int offset, unsigned int *imported)
+{
+	string_new(, id, config_id_size);
+	char blob[config_value_size];
+	int eol, separator, value_offset, value_length, blob_length;
+
+	*imported = 0;
+
+	for(; offset < string_length(src); offset = eol + 1)
 	{
-		config_current = &config_entries[ix];
+		if((eol = string_find(src, offset, '\n')) < 0)
+			eol = string_length(src);
 
-		if(!config_current->id[0])
+		value_length = eol - offset;
+
+		if((value_length > 0) && (string_index(src, eol - 1) == '\r'))
+			value_length--;
+
+		if((value_length == 0) || (string_index(src, offset) == '%'))
 			continue;
 
-		in_use++;
+		if(((separator = string_find(src, offset, '=')) < 0) || (separator >= (offset + value_length)) ||
+				(separator == offset) || ((separator - offset) >= config_id_size))
+			return(false);
+
+		string_clear(&id);
+		string_splice(&id, src, offset, separator - offset);
+
+		// an id is stored expanded, a format character would be expanded again
+
+		if(string_find(&id, 0, '%') >= 0)
+			return(false);
+
+		value_offset = separator + 1;
+		value_length -= value_offset - offset;
+
+		if((value_length >= (int)(sizeof(CONFIG_BLOB_PREFIX) - 1)) &&
+				!strncmp(string_to_const_ptr(src) + value_offset, CONFIG_BLOB_PREFIX, sizeof(CONFIG_BLOB_PREFIX) - 1))
+		{
+			value_offset += sizeof(CONFIG_BLOB_PREFIX) - 1;
+			value_length -= sizeof(CONFIG_BLOB_PREFIX) - 1;
+
+			if((blob_length = string_hex_to_bin(src, value_offset, value_length, blob, sizeof(blob))) < 0)
+				return(false);
+
+			if(!config_store(string_to_const_ptr(&id), blob, blob_length, blob_length, config_entry_flag_blob))
+				return(false);
+		}
+		else
+			if(!config_set_string(string_to_const_ptr(&id), -1, -1, src, value_offset, value_length))
+				return(false);
+
+		(*imported)++;
+	}
+
+	return(true);
+}
+
+irom void config_export(string_t *dst)
+{
+	config_entry_t *entry;
+	unsigned int offset;
+
+	string_cat(dst, CONFIG_MAGIC);
+	string_cat(dst, "\n");
+
+	for(offset = 0; offset < config_arena_length; offset += entry->length)
+	{
+		entry = config_entry_at(offset);
+
+		string_format(dst, "%s=", entry->id);
+
+		if(entry->flags & config_entry_flag_blob)
+			string_cat(dst, CONFIG_BLOB_PREFIX);
+
+		config_entry_format_value(dst, entry);
+		string_cat(dst, "\n");
+	}
+}
+
+irom void config_dump(string_t *dst)
+{
+	config_entry_t *entry;
+	unsigned int offset;
+
+	for(offset = 0; offset < config_arena_length; offset += entry->length)
+	{
+		entry = config_entry_at(offset);
 
-		string_format(dst, "%s=%s (%d)\n", config_current->id, config_current->string_value, config_current->int_value);
+		string_format(dst, "%s=", entry->id);
+		config_entry_format_value(dst, entry);
+		string_format(dst, " (%d%s)\n", entry->int_value, (entry->flags & config_entry_flag_string) ? "" :
+				((entry->flags & config_entry_flag_blob) ? ", blob" : ", int"));
 	}
 
-	string_format(dst, "\nslots total: %u, config items: %u, free slots: %u\n", config_entries_size, in_use, config_entries_size - in_use);
+	string_format(dst, "\nconfig items: %u/%u, arena used: %u/%u bytes\n",
+			config_entries_length, config_entries_size - 1, config_arena_length, config_arena_size);
+	string_format(dst, "log sector: %x (%u/%u), sequence: %u, used: %u, compact: %s\n",
+			USER_CONFIG_LOG_SECTOR + config_log.sector, config_log.sector + 1, config_log_sectors_size,
+			config_log.sequence, config_log.offset, yesno(config_log.compact));
 }
@@ -29,6 +29,19 @@ typedef union
 	uint32_t intval;
 } config_flags_t;
 
+typedef struct
+{
+	config_flags_t	flags;
+	unsigned int	pwm_period;
+	int				display_fliptimeout;
+	int				trigger_status_io;
+	int				trigger_status_pin;
+	int				trigger_assoc_io;
+	int				trigger_assoc_pin;
+} config_runtime_t;
+
+const config_runtime_t *config_runtime_get(void);
+
 config_flags_t	config_flags_get(void);
 bool_t			config_flags_set(config_flags_t);
 void			config_flags_to_string(string_t *);
@@ -38,10 +51,14 @@ bool_t			config_get_string(const char *id, int index1, int index2, string_t *val
 bool_t			config_get_int(const char *id, int index1, int index2, int *value);
 bool_t			config_set_string(const char *id, int index1, int index2, const string_t *value, int value_offset, int value_length);
 bool_t			config_set_int(const char *id, int index1, int index2, int value);
+bool_t			config_get_blob(const char *id, int index1, int index2, void *value, int length);
+bool_t			config_set_blob(const char *id, int index1, int index2, const void *value, int length);
 unsigned int	config_delete(const char *id, int index1, int index2, bool_t wildcard);
 
 bool_t			config_read(void);
 unsigned int	config_write(void);
 void			config_dump(string_t *);
+bool_t			config_import(const string_t *src, int offset, unsigned int *imported);
+void			config_export(string_t *);
 
 #endif
@@ -436,8 +436,7 @@ irom bool display_periodic(void) // gets called 10 times per second
 		expire_counter = 0;
 		display_expire();
 
-		if(!config_get_int("display.fliptimeout", 0, 0, &flip_timeout))
-			flip_timeout = 4;
+		flip_timeout = config_runtime_get()->display_fliptimeout;
 
 		if((last_update > now) || ((last_update + flip_timeout) < now))
 		{
@@ -210,8 +210,7 @@ irom bool_t display_lcd_bright(int brightness)
 	if(!send_byte(cmds[brightness], false))
 		return(false);
 
-	if(!config_get_int("pwm.period", -1, -1, &pwm_period))
-		pwm_period = 65536;
+	pwm_period = config_runtime_get()->pwm_period;
 
 	pwm = bls[brightness] / (65536 / pwm_period);
 
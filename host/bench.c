@@ -0,0 +1,317 @@
+#include "host.h"
+#include "config.h"
+#include "io.h"
+
+// host benchmarks, the absolute numbers are for the host cpu,
+// only compare them with each other
+
+string_new(static, reply, 4096);
+
+// io tick, every pin of every io configured, a mix of counters, inputs, running timers
+// and running analog ramps
+
+static void bench_io(void)
+{
+	static const char * const modes[4][2] =
+	{
+		{ "counter 20", "inputd" },
+		{ "inputd", "inputd" },
+		{ "timer up 50", "outputd" },
+		{ "outputa 0 1000 100", "outputd" },
+	};
+	string_new(static, command, 64);
+	int io, pin, pins, ix, ticks;
+	unsigned int transactions;
+	uint64_t start, spent;
+
+	host_reset();
+	host_i2c_attach(host_i2c_mcp, true);
+	host_i2c_attach(host_i2c_pcf, true);
+	config_set_int("sim.enable", -1, -1, 1);
+	io_init();
+
+	for(io = 0, pins = 0; io < io_id_size; io++)
+	{
+		for(pin = 0; pin < max_pins_per_io; pin++)
+		{
+			for(ix = 0; ix < 2; ix++)
+			{
+				string_clear(&command);
+				string_format(&command, "io-mode %d %d %s", io, pin, modes[pin % 4][ix]);
+
+				if(host_command(application_function_io_mode, string_to_ptr(&command), &reply) == app_action_normal)
+					break;
+			}
+
+			if(ix >= 2)
+				continue;
+
+			pins++;
+
+			if(((pin % 4) == 2) || ((pin % 4) == 3))
+			{
+				string_clear(&command);
+				string_format(&command, "io-set-flag %d %d repeat", io, pin);
+				host_command(application_function_io_set_flag, string_to_ptr(&command), &reply);
+
+				string_clear(&command);
+				string_format(&command, "io-trigger %d %d on", io, pin);
+				host_command(application_function_io_trigger, string_to_ptr(&command), &reply);
+			}
+		}
+	}
+
+	ticks = 100000;
+	transactions = host_i2c_transactions();
+	start = host_ns();
+
+	for(ix = 0; ix < ticks; ix++)
+		host_tick();
+
+	spent = host_ns() - start;
+	transactions = host_i2c_transactions() - transactions;
+
+	host_printf("io tick, %d pins configured: %u ns per tick, %.2f i2c transactions per tick\n",
+			pins, (unsigned int)(spent / ticks), (double)transactions / ticks);
+}
+
+// config lookup, the hashed index against the linear scan over fixed size entries it replaced
+
+enum
+{
+	bench_config_keys = 90,
+	bench_config_lookups = 1000000,
+};
+
+typedef struct
+{
+	char	id[28];
+	char	string_value[32];
+	int		int_value;
+} bench_config_entry_t;
+
+static unsigned int bench_config_entries_length;
+static bench_config_entry_t bench_config_entries[100];
+
+static const bench_config_entry_t *bench_config_find_linear(const char *id, int index1, int index2)
+{
+	string_new(static, varid, 64);
+	unsigned int ix;
+
+	string_clear(&varid);
+	string_format_data(&varid, id, index1, index2);
+
+	for(ix = 0; ix < bench_config_entries_length; ix++)
+		if(string_match(&varid, bench_config_entries[ix].id))
+			return(&bench_config_entries[ix]);
+
+	return((const bench_config_entry_t *)0);
+}
+
+static void bench_config(void)
+{
+	static const struct
+	{
+		const char	*id;
+		int			index1;
+		int			index2;
+	} lookups[] =
+	{
+		{ "flags", -1, -1 },
+		{ "trigger.status.io", -1, -1 },
+		{ "io.%u.%u.mode", 4, 15 },
+		{ "io.%u.%u.llmode", 3, 3 },
+	};
+	string_new(static, varid, 64);
+	unsigned int ix, lookup, found;
+	uint64_t start, linear, hashed;
+	int value;
+
+	host_reset();
+
+	config_set_int("flags", -1, -1, 0);
+	config_set_int("trigger.status.io", -1, -1, 4);
+	config_set_int("trigger.status.pin", -1, -1, 0);
+	strlcpy(bench_config_entries[0].id, "flags", sizeof(bench_config_entries[0].id));
+	strlcpy(bench_config_entries[1].id, "trigger.status.io", sizeof(bench_config_entries[1].id));
+	strlcpy(bench_config_entries[2].id, "trigger.status.pin", sizeof(bench_config_entries[2].id));
+
+	for(ix = 3; ix < bench_config_keys; ix++)
+	{
+		config_set_int("io.%u.%u.mode", ix / 16, ix % 16, ix);
+
+		string_clear(&varid);
+		string_format_data(&varid, "io.%u.%u.mode", ix / 16, ix % 16);
+		strlcpy(bench_config_entries[ix].id, string_to_ptr(&varid), sizeof(bench_config_entries[ix].id));
+		bench_config_entries[ix].int_value = ix;
+	}
+
+	bench_config_entries_length = bench_config_keys;
+
+	for(lookup = 0; lookup < (sizeof(lookups) / sizeof(*lookups)); lookup++)
+	{
+		start = host_ns();
+
+		for(ix = 0, found = 0; ix < bench_config_lookups; ix++)
+			if(bench_config_find_linear(lookups[lookup].id, lookups[lookup].index1, lookups[lookup].index2))
+				found++;
+
+		linear = host_ns() - start;
+		start = host_ns();
+
+		for(ix = 0; ix < bench_config_lookups; ix++)
+			if(config_get_int(lookups[lookup].id, lookups[lookup].index1, lookups[lookup].index2, &value))
+				found--;
+
+		hashed = host_ns() - start;
+
+		host_printf("config lookup %-17s (%s), %d keys: linear %4u ns, hashed %4u ns\n",
+				lookups[lookup].id, found ? "mismatch" : (lookup == 3) ? "miss" : "hit", bench_config_keys,
+				(unsigned int)(linear / bench_config_lookups), (unsigned int)(hashed / bench_config_lookups));
+	}
+}
+
+// string_format, the direct formatter against the old path: copy the format from flash into a
+// 1 KB ram buffer, then ets_vsnprintf into the string
+
+int ets_vsnprintf(char *, size_t, const char *, va_list);
+
+enum
+{
+	bench_format_calls = 1000000,
+};
+
+static char bench_format_buffer[1024];
+
+static size_t bench_copy_flash_to_ram(char *dst, const char *from_ptr_byte, int size)
+{
+	int from, to;
+	uint32_t current32, byte;
+	uint8_t current8;
+	const uint32_t *from_ptr;
+
+	from_ptr = (const uint32_t *)(const void *)from_ptr_byte;
+
+	for(from = 0, to = 0; (int)(from * sizeof(*from_ptr)) < (size - 1); from++)
+	{
+		current32 = from_ptr[from];
+
+		for(byte = 4; byte > 0; byte--)
+		{
+			if((current8 = (current32 & 0x000000ff)) == '\0')
+				goto done;
+
+			if((to + 1) >= size)
+				goto done;
+
+			dst[to++] = (char)current8;
+			current32 = (current32 >> 8) & 0x00ffffff;
+		}
+	}
+
+done:
+	dst[to] = '\0';
+
+	return(to);
+}
+
+static void bench_format_old(string_t *dst, const char *fmt_flash, ...)
+{
+	va_list ap;
+
+	bench_copy_flash_to_ram(bench_format_buffer, fmt_flash, sizeof(bench_format_buffer));
+
+	va_start(ap, fmt_flash);
+	dst->length += ets_vsnprintf(dst->buffer + dst->length, dst->size - dst->length - 1, bench_format_buffer, ap);
+	va_end(ap);
+
+	if(dst->length > (dst->size - 1))
+		dst->length = dst->size - 1;
+
+	dst->buffer[dst->length] = '\0';
+}
+
+static void bench_format(void)
+{
+	static roflash const char fmt_short[] = "%u";
+	static roflash const char fmt_dump[] = "> %-12s %2d/%2d: %-10s %6d %04x\n";
+	static roflash const char fmt_long[] =
+		"> pin: %2d, io: %d, mode: %s, flags: [%s], value: %u, state: %s, this line is a bit longer\n";
+	unsigned int ix;
+	uint64_t start, old, direct;
+
+	start = host_ns();
+
+	for(ix = 0; ix < bench_format_calls; ix++)
+	{
+		string_clear(&reply);
+		bench_format_old(&reply, fmt_short, ix);
+	}
+
+	old = host_ns() - start;
+	start = host_ns();
+
+	for(ix = 0; ix < bench_format_calls; ix++)
+	{
+		string_clear(&reply);
+		string_format_ptr(&reply, fmt_short, ix);
+	}
+
+	direct = host_ns() - start;
+
+	host_printf("string_format short: ram copy + vsnprintf %4u ns, direct %4u ns\n",
+			(unsigned int)(old / bench_format_calls), (unsigned int)(direct / bench_format_calls));
+
+	start = host_ns();
+
+	for(ix = 0; ix < bench_format_calls; ix++)
+	{
+		string_clear(&reply);
+		bench_format_old(&reply, fmt_dump, "mcp23017", ix & 0x0f, 16, "counter", -(int)ix, ix & 0xffff);
+	}
+
+	old = host_ns() - start;
+	start = host_ns();
+
+	for(ix = 0; ix < bench_format_calls; ix++)
+	{
+		string_clear(&reply);
+		string_format_ptr(&reply, fmt_dump, "mcp23017", ix & 0x0f, 16, "counter", -(int)ix, ix & 0xffff);
+	}
+
+	direct = host_ns() - start;
+
+	host_printf("string_format dump:  ram copy + vsnprintf %4u ns, direct %4u ns\n",
+			(unsigned int)(old / bench_format_calls), (unsigned int)(direct / bench_format_calls));
+
+	start = host_ns();
+
+	for(ix = 0; ix < bench_format_calls; ix++)
+	{
+		string_clear(&reply);
+		bench_format_old(&reply, fmt_long, ix & 0x0f, 4, "counter", "autostart, repeat", ix, "running");
+	}
+
+	old = host_ns() - start;
+	start = host_ns();
+
+	for(ix = 0; ix < bench_format_calls; ix++)
+	{
+		string_clear(&reply);
+		string_format_ptr(&reply, fmt_long, ix & 0x0f, 4, "counter", "autostart, repeat", ix, "running");
+	}
+
+	direct = host_ns() - start;
+
+	host_printf("string_format long:  ram copy + vsnprintf %4u ns, direct %4u ns\n",
+			(unsigned int)(old / bench_format_calls), (unsigned int)(direct / bench_format_calls));
+}
+
+int main(void)
+{
+	bench_io();
+	bench_config();
+	bench_format();
+
+	return(0);
+}
@@ -0,0 +1,15 @@
+#include <stdint.h>
+#include <time.h>
+
+// wall clock for the benchmarks, kept apart because util.h has its own struct tm
+
+uint64_t host_ns(void);
+
+uint64_t host_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return(((uint64_t)now.tv_sec * 1000000000) + now.tv_nsec);
+}
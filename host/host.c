@@ -0,0 +1,92 @@
+#include "host.h"
+#include "config.h"
+#include "io.h"
+
+#include <string.h>
+
+// test harness, runs the io engine the way user_main does: io_periodic_fast from the 10 ms timer,
+// then io_periodic_deferred from the background task until it has caught up
+
+enum
+{
+	host_tick_us = 10000,
+};
+
+static unsigned int host_checks;
+static unsigned int host_failures;
+
+void host_reset(void)
+{
+	int pin;
+
+	host_flash_wipe();
+	config_read();
+
+	host_i2c_attach(host_i2c_mcp, false);
+	host_i2c_attach(host_i2c_pcf, false);
+	host_i2c_attach(host_i2c_bme280, false);
+	host_i2c_attach(host_i2c_digipicco, false);
+
+	for(pin = 0; pin < 16; pin++)
+		host_gpio_input(pin, false);
+}
+
+void host_tick_now(void)
+{
+	host_timer1_period();
+
+	if(io_periodic_fast())
+		while(io_periodic_deferred())
+			;
+}
+
+void host_tick(void)
+{
+	host_advance(host_tick_us);
+	host_tick_now();
+}
+
+void host_ticks(int ticks)
+{
+	while(ticks-- > 0)
+		host_tick();
+}
+
+app_action_t host_command(app_action_t (*fn)(const string_t *, string_t *), const char *command, string_t *dst)
+{
+	string_new(static, src, 256);
+
+	string_clear(&src);
+	string_cat_strptr(&src, command);
+	string_clear(dst);
+
+	return(fn(&src, dst));
+}
+
+int host_read(int io, int pin)
+{
+	int value;
+
+	if(io_read_pin((string_t *)0, io, pin, &value) != io_ok)
+		return(-1);
+
+	return(value);
+}
+
+void host_check(bool_t ok, const char *expression, const char *file, int line)
+{
+	host_checks++;
+
+	if(ok)
+		return;
+
+	host_failures++;
+	host_printf("%s:%d: check failed: %s\n", file, line, expression);
+}
+
+int host_report(void)
+{
+	host_printf("%u checks, %u failed\n", host_checks, host_failures);
+
+	return(host_failures ? 1 : 0);
+}
@@ -0,0 +1,72 @@
+#ifndef host_h
+#define host_h
+
+// host build of the io engine, config store and string functions, the sdk is replaced by
+// the shim in host/sdk and host/sdk.c, the i2c bus by the devices in host/i2c.c
+
+#include "util.h"
+#include "application.h"
+
+#include <stdint.h>
+
+// virtual clock, ets timers fire when it's advanced
+
+uint64_t	host_time(void);
+void		host_advance(uint32_t us);
+
+// gpio pads, an input change raises the gpio interrupt when the pin's edge interrupt is enabled
+
+void		host_gpio_input(int pin, bool_t level);
+bool_t		host_gpio_output(int pin);
+void		host_adc_value(unsigned int value);
+
+// flash, ram backed, starts erased
+
+void			host_flash_wipe(void);
+unsigned int	host_flash_erases(int sector);
+
+// i2c devices
+
+enum
+{
+	host_i2c_mcp = 0x20,
+	host_i2c_pcf = 0x3a,
+	host_i2c_bme280 = 0x76,
+	host_i2c_digipicco = 0x78,
+};
+
+void			host_i2c_attach(int address, bool_t attached);
+unsigned int	host_i2c_transactions(void);
+void			host_mcp_input(int pin, bool_t level);
+bool_t			host_mcp_output(int pin);
+void			host_pcf_input(int pin, bool_t level);
+bool_t			host_pcf_output(int pin);
+void			host_bme280_write(int reg, int value);
+void			host_digipicco_set(int humidity, int temperature);
+
+// harness
+
+void			host_reset(void);
+void			host_timer1_period(void);
+void			host_tick_now(void);
+void			host_tick(void);
+void			host_ticks(int ticks);
+app_action_t	host_command(app_action_t (*fn)(const string_t *, string_t *), const char *command, string_t *dst);
+int				host_read(int io, int pin);
+int				host_printf(const char *fmt, ...) __attribute__ ((format (printf, 1, 2)));
+uint64_t		host_ns(void);
+
+void	host_check(bool_t ok, const char *expression, const char *file, int line);
+int		host_report(void);
+
+#define check(expression) host_check(!!(expression), #expression, __FILE__, __LINE__)
+
+// test groups, host/test_*.c
+
+void test_io_sim(void);
+void test_config_arena(void);
+void test_util(void);
+void test_sensor(void);
+void test_debounce(void);
+
+#endif
@@ -0,0 +1,392 @@
+#include "host.h"
+#include "i2c.h"
+
+#include <string.h>
+
+// i2c bus for the host build, with register models of the devices the io code talks to:
+// an mcp23017 at 0x20 (IOCON.BANK = 0, interrupt on change, INTF/INTCAP),
+// a pcf8574a at 0x3a (quasi-bidirectional pins), a bme280 at 0x76 (a plain register file)
+// and a digipicco at 0x78 (four bytes, humidity and temperature)
+
+enum
+{
+	mcp_registers = 0x16,
+	mcp_iodir = 0x00,
+	mcp_gpinten = 0x04,
+	mcp_intcon = 0x08,
+	mcp_iocon = 0x0a,
+	mcp_intf = 0x0e,
+	mcp_intcap = 0x10,
+	mcp_gpio = 0x12,
+	mcp_olat = 0x14,
+};
+
+typedef struct
+{
+	bool_t	attached;
+	uint8_t	reg[mcp_registers];
+	uint8_t	pointer;
+	uint8_t	pins[2];
+} host_mcp_t;
+
+typedef struct
+{
+	bool_t	attached;
+	uint8_t	latch;
+	uint8_t	pins;
+} host_pcf_t;
+
+typedef struct
+{
+	bool_t	attached;
+	uint8_t	reg[256];
+	uint8_t	pointer;
+} host_bme280_t;
+
+typedef struct
+{
+	bool_t	attached;
+	uint8_t	data[4];
+} host_digipicco_t;
+
+static host_mcp_t host_mcp;
+static host_pcf_t host_pcf;
+static host_bme280_t host_bme280;
+static host_digipicco_t host_digipicco;
+static unsigned int host_i2c_transaction_count;
+
+void host_i2c_attach(int address, bool_t attached)
+{
+	switch(address)
+	{
+		case(host_i2c_mcp):
+		{
+			memset(&host_mcp, 0, sizeof(host_mcp));
+			host_mcp.reg[mcp_iodir + 0] = 0xff;
+			host_mcp.reg[mcp_iodir + 1] = 0xff;
+			host_mcp.attached = attached;
+
+			break;
+		}
+
+		case(host_i2c_pcf):
+		{
+			host_pcf.latch = 0xff;
+			host_pcf.pins = 0xff;
+			host_pcf.attached = attached;
+
+			break;
+		}
+
+		case(host_i2c_bme280):
+		{
+			memset(&host_bme280, 0, sizeof(host_bme280));
+			host_bme280.reg[0xd0] = 0x60;
+			host_bme280.attached = attached;
+
+			break;
+		}
+
+		case(host_i2c_digipicco):
+		{
+			memset(&host_digipicco, 0, sizeof(host_digipicco));
+			host_digipicco.attached = attached;
+
+			break;
+		}
+
+		default:
+		{
+			break;
+		}
+	}
+}
+
+unsigned int host_i2c_transactions(void)
+{
+	return(host_i2c_transaction_count);
+}
+
+// mcp23017
+
+static uint8_t host_mcp_port(int port)
+{
+	uint8_t iodir = host_mcp.reg[mcp_iodir + port];
+
+	return((host_mcp.pins[port] & iodir) | (host_mcp.reg[mcp_olat + port] & ~iodir));
+}
+
+void host_mcp_input(int pin, bool_t level)
+{
+	int port = pin >> 3;
+	uint8_t bit = 1 << (pin & 0x07);
+	uint8_t old;
+
+	old = host_mcp_port(port);
+
+	if(level)
+		host_mcp.pins[port] |= bit;
+	else
+		host_mcp.pins[port] &= ~bit;
+
+	// interrupt on change against the previous value, the first change captures the port,
+	// further changes don't until the interrupt is cleared by reading GPIO or INTCAP
+
+	if(((old ^ host_mcp_port(port)) & bit) && (host_mcp.reg[mcp_gpinten + port] & bit) &&
+			!(host_mcp.reg[mcp_intcon + port] & bit) && !host_mcp.reg[mcp_intf + port])
+	{
+		host_mcp.reg[mcp_intf + port] = bit;
+		host_mcp.reg[mcp_intcap + port] = host_mcp_port(port);
+	}
+}
+
+bool_t host_mcp_output(int pin)
+{
+	return(!!(host_mcp_port(pin >> 3) & (1 << (pin & 0x07))));
+}
+
+static void host_mcp_write(int length, const uint8_t *bytes)
+{
+	uint8_t reg;
+
+	if(length < 1)
+		return;
+
+	host_mcp.pointer = bytes[0] % mcp_registers;
+
+	for(bytes++, length--; length > 0; bytes++, length--)
+	{
+		reg = host_mcp.pointer;
+
+		switch(reg)
+		{
+			case(mcp_iocon + 0):
+			case(mcp_iocon + 1):
+			{
+				host_mcp.reg[mcp_iocon + 0] = *bytes;
+				host_mcp.reg[mcp_iocon + 1] = *bytes;
+				break;
+			}
+
+			case(mcp_intf + 0):
+			case(mcp_intf + 1):
+			case(mcp_intcap + 0):
+			case(mcp_intcap + 1):
+			{
+				break;
+			}
+
+			case(mcp_gpio + 0):
+			case(mcp_gpio + 1):
+			{
+				host_mcp.reg[mcp_olat + (reg - mcp_gpio)] = *bytes;
+				break;
+			}
+
+			default:
+			{
+				host_mcp.reg[reg] = *bytes;
+				break;
+			}
+		}
+
+		host_mcp.pointer = (host_mcp.pointer + 1) % mcp_registers;
+	}
+}
+
+static void host_mcp_read(int length, uint8_t *bytes)
+{
+	uint8_t reg;
+
+	for(; length > 0; bytes++, length--)
+	{
+		reg = host_mcp.pointer;
+
+		switch(reg)
+		{
+			case(mcp_gpio + 0):
+			case(mcp_gpio + 1):
+			{
+				*bytes = host_mcp_port(reg - mcp_gpio);
+				host_mcp.reg[mcp_intf + (reg - mcp_gpio)] = 0;
+				break;
+			}
+
+			case(mcp_intcap + 0):
+			case(mcp_intcap + 1):
+			{
+				*bytes = host_mcp.reg[reg];
+				host_mcp.reg[mcp_intf + (reg - mcp_intcap)] = 0;
+				break;
+			}
+
+			default:
+			{
+				*bytes = host_mcp.reg[reg];
+				break;
+			}
+		}
+
+		host_mcp.pointer = (host_mcp.pointer + 1) % mcp_registers;
+	}
+}
+
+// pcf8574, a pin reads low when either the latch or the outside pulls it low
+
+void host_pcf_input(int pin, bool_t level)
+{
+	if(level)
+		host_pcf.pins |= 1 << pin;
+	else
+		host_pcf.pins &= ~(1 << pin);
+}
+
+bool_t host_pcf_output(int pin)
+{
+	return(!!(host_pcf.latch & (1 << pin)));
+}
+
+// bme280, registers auto increment from the pointer set by the first byte written
+
+void host_bme280_write(int reg, int value)
+{
+	host_bme280.reg[reg & 0xff] = value;
+}
+
+static void host_bme280_send(int length, const uint8_t *bytes)
+{
+	if(length < 1)
+		return;
+
+	host_bme280.pointer = bytes[0];
+
+	for(bytes++, length--; length > 0; bytes++, length--)
+		host_bme280.reg[host_bme280.pointer++] = *bytes;
+}
+
+static void host_bme280_receive(int length, uint8_t *bytes)
+{
+	for(; length > 0; bytes++, length--)
+		*bytes = host_bme280.reg[host_bme280.pointer++];
+}
+
+// digipicco, every read returns the last measurement
+
+void host_digipicco_set(int humidity, int temperature)
+{
+	host_digipicco.data[0] = (humidity >> 8) & 0xff;
+	host_digipicco.data[1] = (humidity >> 0) & 0xff;
+	host_digipicco.data[2] = (temperature >> 8) & 0xff;
+	host_digipicco.data[3] = (temperature >> 0) & 0xff;
+}
+
+// i2c.h
+
+void i2c_init(int sda_index, int scl_index)
+{
+}
+
+i2c_error_t i2c_select_bus(unsigned int bus)
+{
+	return(i2c_error_ok);
+}
+
+void i2c_get_info(i2c_info_t *info)
+{
+	info->multiplexer = 0;
+	info->buses = 1;
+	info->delay = 0;
+}
+
+void i2c_error_format_string(string_t *dst, i2c_error_t error)
+{
+	string_format(dst, "i2c error %d", (int)error);
+}
+
+i2c_error_t i2c_send(int address, int length, const uint8_t *bytes)
+{
+	host_i2c_transaction_count++;
+
+	if((address == host_i2c_mcp) && host_mcp.attached)
+	{
+		host_mcp_write(length, bytes);
+		return(i2c_error_ok);
+	}
+
+	if((address == host_i2c_pcf) && host_pcf.attached)
+	{
+		if(length > 0)
+			host_pcf.latch = bytes[length - 1];
+
+		return(i2c_error_ok);
+	}
+
+	if((address == host_i2c_bme280) && host_bme280.attached)
+	{
+		host_bme280_send(length, bytes);
+		return(i2c_error_ok);
+	}
+
+	return(i2c_error_address_nak);
+}
+
+i2c_error_t i2c_receive(int address, int length, uint8_t *bytes)
+{
+	host_i2c_transaction_count++;
+
+	if((address == host_i2c_mcp) && host_mcp.attached)
+	{
+		host_mcp_read(length, bytes);
+		return(i2c_error_ok);
+	}
+
+	if((address == host_i2c_pcf) && host_pcf.attached)
+	{
+		for(; length > 0; bytes++, length--)
+			*bytes = host_pcf.latch & host_pcf.pins;
+
+		return(i2c_error_ok);
+	}
+
+	if((address == host_i2c_bme280) && host_bme280.attached)
+	{
+		host_bme280_receive(length, bytes);
+		return(i2c_error_ok);
+	}
+
+	if((address == host_i2c_digipicco) && host_digipicco.attached)
+	{
+		memcpy(bytes, host_digipicco.data, (length < 4) ? length : 4);
+		return(i2c_error_ok);
+	}
+
+	return(i2c_error_address_nak);
+}
+
+i2c_error_t i2c_send_1(int address, int byte0)
+{
+	uint8_t bytes[1] = { byte0 };
+
+	return(i2c_send(address, sizeof(bytes), bytes));
+}
+
+i2c_error_t i2c_send_2(int address, int byte0, int byte1)
+{
+	uint8_t bytes[2] = { byte0, byte1 };
+
+	return(i2c_send(address, sizeof(bytes), bytes));
+}
+
+i2c_error_t i2c_send_3(int address, int byte0, int byte1, int byte2)
+{
+	uint8_t bytes[3] = { byte0, byte1, byte2 };
+
+	return(i2c_send(address, sizeof(bytes), bytes));
+}
+
+i2c_error_t i2c_send_4(int address, int byte0, int byte1, int byte2, int byte3)
+{
+	uint8_t bytes[4] = { byte0, byte1, byte2, byte3 };
+
+	return(i2c_send(address, sizeof(bytes), bytes));
+}
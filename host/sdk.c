@@ -0,0 +1,400 @@
+// util.h declares its own dprintf, keep the one from stdio.h out of the way
+
+#define dprintf stdio_dprintf
+#include <stdio.h>
+#undef dprintf
+
+#include "host.h"
+#include "io_gpio.h"
+#include "queue.h"
+#include "stats.h"
+#include "ota.h"
+#include "uart.h"
+#include "user_main.h"
+
+#include <user_interface.h>
+#include <spi_flash.h>
+
+#include <stdarg.h>
+#include <string.h>
+
+// sdk shim for the host build: a virtual microsecond clock with the ets timers on it,
+// a register file for the peripherals the io code touches, the interrupt controller
+// and a ram backed flash
+
+// clock and timers
+
+enum
+{
+	host_timers_size = 8,
+};
+
+typedef struct
+{
+	ETSTimer	*timer;
+	uint64_t	expire;
+	uint32_t	period;
+} host_timer_t;
+
+static uint64_t host_clock;
+static host_timer_t host_timers[host_timers_size];
+
+uint64_t host_time(void)
+{
+	return(host_clock);
+}
+
+uint32 system_get_time(void)
+{
+	return((uint32_t)host_clock);
+}
+
+void ets_delay_us(uint16_t us)
+{
+	host_clock += us;
+}
+
+void ets_timer_setfn(ETSTimer *timer, ETSTimerFunc *fn, void *arg)
+{
+	timer->timer_func = fn;
+	timer->timer_arg = arg;
+}
+
+void ets_timer_disarm(ETSTimer *timer)
+{
+	int ix;
+
+	for(ix = 0; ix < host_timers_size; ix++)
+		if(host_timers[ix].timer == timer)
+			host_timers[ix].timer = (ETSTimer *)0;
+}
+
+void ets_timer_arm_new(ETSTimer *timer, uint32_t time, bool_t repeat, int ms)
+{
+	int ix, slot;
+
+	ets_timer_disarm(timer);
+
+	for(slot = -1, ix = 0; ix < host_timers_size; ix++)
+		if(!host_timers[ix].timer)
+			slot = ix;
+
+	if(slot < 0)
+		return;
+
+	if(ms)
+		time *= 1000;
+
+	host_timers[slot].timer = timer;
+	host_timers[slot].expire = host_clock + time;
+	host_timers[slot].period = repeat ? time : 0;
+}
+
+void host_advance(uint32_t us)
+{
+	uint64_t target;
+	host_timer_t *next;
+	ETSTimer *timer;
+	int ix;
+
+	target = host_clock + us;
+
+	for(;;)
+	{
+		for(next = (host_timer_t *)0, ix = 0; ix < host_timers_size; ix++)
+			if(host_timers[ix].timer && (host_timers[ix].expire <= target) && (!next || (host_timers[ix].expire < next->expire)))
+				next = &host_timers[ix];
+
+		if(!next)
+			break;
+
+		timer = next->timer;
+
+		if(next->expire > host_clock)
+			host_clock = next->expire;
+
+		if(next->period)
+			next->expire += next->period;
+		else
+			next->timer = (ETSTimer *)0;
+
+		timer->timer_func(timer->timer_arg);
+	}
+
+	host_clock = target;
+}
+
+// interrupt controller
+
+typedef void (*host_isr_t)(void *);
+
+static host_isr_t host_isr[32];
+static void *host_isr_arg[32];
+static uint32_t host_intenable_mask;
+
+uint32_t host_intenable(void)
+{
+	return(host_intenable_mask);
+}
+
+void ets_isr_attach(int number, void *fn, void *arg)
+{
+	host_isr[number] = (host_isr_t)fn;
+	host_isr_arg[number] = arg;
+}
+
+static void host_gpio_raise(void);
+
+// the frc1 timer isr (pwm or sequence), one call per timer reload, enough calls to pass through a full pwm period
+
+void host_timer1_period(void)
+{
+	int call;
+
+	for(call = 0; (call < 64) && host_isr[ETS_FRC_TIMER1_INUM] && (host_intenable_mask & (1 << ETS_FRC_TIMER1_INUM)); call++)
+		host_isr[ETS_FRC_TIMER1_INUM](host_isr_arg[ETS_FRC_TIMER1_INUM]);
+}
+
+void ets_isr_mask(unsigned int mask)
+{
+	host_intenable_mask &= ~mask;
+}
+
+void ets_isr_unmask(unsigned int mask)
+{
+	host_intenable_mask |= mask;
+
+	if(mask & (1 << ETS_GPIO_INUM))
+		host_gpio_raise();
+}
+
+// register file, the gpio block implements the set/clear registers and
+// feeds the input register from the pads, everything else is plain memory
+
+enum
+{
+	host_reg_base = 0x60000000,
+	host_reg_size = 0x1000,
+	host_dport_base = 0x3ff00000,
+	host_dport_size = 0x100,
+};
+
+static uint32_t host_reg[host_reg_size / 4];
+static uint32_t host_dport[host_dport_size / 4];
+static uint32_t host_pads;
+static unsigned int host_adc;
+
+static uint32_t *host_reg_ptr(uint32_t address)
+{
+	if((address >= host_reg_base) && (address < (host_reg_base + host_reg_size)))
+		return(&host_reg[(address - host_reg_base) / 4]);
+
+	if((address >= host_dport_base) && (address < (host_dport_base + host_dport_size)))
+		return(&host_dport[(address - host_dport_base) / 4]);
+
+	host_printf("sdk: access to unknown register 0x%08x\n", (unsigned int)address);
+
+	return((uint32_t *)0);
+}
+
+static uint32_t *host_gpio_reg(int reg)
+{
+	return(&host_reg[(PERIPHS_GPIO_BASEADDR - host_reg_base + reg) / 4]);
+}
+
+uint32_t host_reg_read(uint32_t address)
+{
+	uint32_t *reg;
+
+	if(address == (PERIPHS_GPIO_BASEADDR + GPIO_IN_ADDRESS))
+	{
+		uint32_t enable = *host_gpio_reg(GPIO_ENABLE_ADDRESS);
+
+		return(((*host_gpio_reg(GPIO_OUT_ADDRESS) & enable) | (host_pads & ~enable)) & 0xffff);
+	}
+
+	if(!(reg = host_reg_ptr(address)))
+		return(0);
+
+	return(*reg);
+}
+
+void host_reg_write(uint32_t address, uint32_t value)
+{
+	uint32_t *reg;
+
+	switch(address - PERIPHS_GPIO_BASEADDR)
+	{
+		case(GPIO_OUT_W1TS_ADDRESS): { *host_gpio_reg(GPIO_OUT_ADDRESS) |= value; return; }
+		case(GPIO_OUT_W1TC_ADDRESS): { *host_gpio_reg(GPIO_OUT_ADDRESS) &= ~value; return; }
+		case(GPIO_ENABLE_W1TS_ADDRESS): { *host_gpio_reg(GPIO_ENABLE_ADDRESS) |= value; return; }
+		case(GPIO_ENABLE_W1TC_ADDRESS): { *host_gpio_reg(GPIO_ENABLE_ADDRESS) &= ~value; return; }
+		case(GPIO_STATUS_W1TS_ADDRESS): { *host_gpio_reg(GPIO_STATUS_ADDRESS) |= value; return; }
+		case(GPIO_STATUS_W1TC_ADDRESS): { *host_gpio_reg(GPIO_STATUS_ADDRESS) &= ~value; return; }
+		default: { break; }
+	}
+
+	if((reg = host_reg_ptr(address)))
+		*reg = value;
+}
+
+static void host_gpio_raise(void)
+{
+	if(*host_gpio_reg(GPIO_STATUS_ADDRESS) && host_isr[ETS_GPIO_INUM] && (host_intenable_mask & (1 << ETS_GPIO_INUM)))
+		host_isr[ETS_GPIO_INUM](host_isr_arg[ETS_GPIO_INUM]);
+}
+
+void host_gpio_input(int pin, bool_t level)
+{
+	uint32_t type, old;
+
+	old = !!(host_pads & (1 << pin));
+
+	if(level)
+		host_pads |= 1 << pin;
+	else
+		host_pads &= ~(1 << pin);
+
+	if((old == !!level) || (*host_gpio_reg(GPIO_ENABLE_ADDRESS) & (1 << pin)))
+		return;
+
+	// interrupt type field of GPIO_PINx: 1 = rising, 2 = falling, 3 = both
+
+	type = (*host_gpio_reg(GPIO_PIN0_ADDRESS + (pin * 4)) >> 7) & 0x07;
+
+	if(((type == 1) && level) || ((type == 2) && !level) || (type == 3))
+	{
+		*host_gpio_reg(GPIO_STATUS_ADDRESS) |= 1 << pin;
+		host_gpio_raise();
+	}
+}
+
+bool_t host_gpio_output(int pin)
+{
+	return(!!(host_reg_read(PERIPHS_GPIO_BASEADDR + GPIO_IN_ADDRESS) & (1 << pin)));
+}
+
+void host_adc_value(unsigned int value)
+{
+	host_adc = value;
+}
+
+uint16 system_adc_read(void)
+{
+	return(host_adc);
+}
+
+// flash, covers the 512 kbyte plain image layout
+
+enum
+{
+	host_flash_sectors = 0x80,
+};
+
+static uint8_t host_flash[host_flash_sectors * SPI_FLASH_SEC_SIZE];
+static unsigned int host_flash_erase_count[host_flash_sectors];
+
+void host_flash_wipe(void)
+{
+	memset(host_flash, 0xff, sizeof(host_flash));
+	memset(host_flash_erase_count, 0, sizeof(host_flash_erase_count));
+}
+
+unsigned int host_flash_erases(int sector)
+{
+	return(host_flash_erase_count[sector]);
+}
+
+SpiFlashOpResult spi_flash_erase_sector(uint16 sector)
+{
+	if(sector >= host_flash_sectors)
+		return(SPI_FLASH_RESULT_ERR);
+
+	memset(&host_flash[sector * SPI_FLASH_SEC_SIZE], 0xff, SPI_FLASH_SEC_SIZE);
+	host_flash_erase_count[sector]++;
+
+	return(SPI_FLASH_RESULT_OK);
+}
+
+SpiFlashOpResult spi_flash_read(uint32_t src, void *dst, uint32_t size)
+{
+	if((src & 3) || ((src + size) > sizeof(host_flash)))
+		return(SPI_FLASH_RESULT_ERR);
+
+	memcpy(dst, &host_flash[src], size);
+
+	return(SPI_FLASH_RESULT_OK);
+}
+
+SpiFlashOpResult spi_flash_write(uint32_t dst, const void *src, uint32_t size)
+{
+	const uint8_t *from = (const uint8_t *)src;
+	uint32_t ix;
+
+	if((dst & 3) || ((dst + size) > sizeof(host_flash)))
+		return(SPI_FLASH_RESULT_ERR);
+
+	// like nor flash, writing can only clear bits
+
+	for(ix = 0; ix < size; ix++)
+		host_flash[dst + ix] &= from[ix];
+
+	return(SPI_FLASH_RESULT_OK);
+}
+
+// system
+
+void system_soft_wdt_feed(void)
+{
+}
+
+void system_restart(void)
+{
+	host_printf("sdk: system_restart\n");
+}
+
+int ets_vsnprintf(char *, size_t, const char *, va_list);
+
+int ets_vsnprintf(char *dst, size_t size, const char *fmt, va_list ap)
+{
+	return(vsnprintf(dst, size, fmt, ap));
+}
+
+int host_printf(const char *fmt, ...)
+{
+	va_list ap;
+	int length;
+
+	va_start(ap, fmt);
+	length = vprintf(fmt, ap);
+	va_end(ap);
+
+	return(length);
+}
+
+// the rest of the firmware, not linked into the host build
+
+static char host_send_buffer[1024];
+queue_t data_send_queue = { host_send_buffer, sizeof(host_send_buffer), 0, 0, 0 };
+
+int stat_pwm_timer_interrupts;
+int stat_sequence_timer_interrupts;
+int stat_pwm_phase_builds;
+int stat_gpio_interrupts;
+int stat_io_deferred_overrun;
+int stat_io_deferred_budget;
+
+bool_t wlan_scan_active(void)
+{
+	return(false);
+}
+
+bool_t ota_is_active(void)
+{
+	return(false);
+}
+
+void uart_start_transmit(char enable)
+{
+	queue_flush(&data_send_queue);
+}
@@ -0,0 +1,96 @@
+#ifndef eagle_soc_h
+#define eagle_soc_h
+
+// host build: minimal stand-in for the sdk's eagle_soc.h, peripheral
+// registers are routed to the register file in host/sdk.c
+
+#include <c_types.h>
+
+uint32_t	host_reg_read(uint32_t address);
+void		host_reg_write(uint32_t address, uint32_t value);
+
+#define READ_PERI_REG(addr) host_reg_read(addr)
+#define WRITE_PERI_REG(addr, val) host_reg_write(addr, val)
+#define CLEAR_PERI_REG_MASK(reg, mask) WRITE_PERI_REG((reg), (READ_PERI_REG(reg) & (~(mask))))
+#define SET_PERI_REG_MASK(reg, mask) WRITE_PERI_REG((reg), (READ_PERI_REG(reg) | (mask)))
+
+#define BIT(nr) (1UL << (nr))
+#define BIT0 0x00000001
+#define BIT1 0x00000002
+#define BIT2 0x00000004
+
+#define PERIPHS_DPORT_BASEADDR 0x3ff00000
+#define PERIPHS_GPIO_BASEADDR 0x60000300
+#define PERIPHS_TIMER_BASEDDR 0x60000600
+#define PERIPHS_RTC_BASEADDR 0x60000700
+#define PERIPHS_IO_MUX 0x60000800
+
+#define EDGE_INT_ENABLE_REG (PERIPHS_DPORT_BASEADDR + 0x04)
+
+#define GPIO_OUT_ADDRESS 0x00
+#define GPIO_OUT_W1TS_ADDRESS 0x04
+#define GPIO_OUT_W1TC_ADDRESS 0x08
+#define GPIO_ENABLE_ADDRESS 0x0c
+#define GPIO_ENABLE_W1TS_ADDRESS 0x10
+#define GPIO_ENABLE_W1TC_ADDRESS 0x14
+#define GPIO_IN_ADDRESS 0x18
+#define GPIO_STATUS_ADDRESS 0x1c
+#define GPIO_STATUS_W1TS_ADDRESS 0x20
+#define GPIO_STATUS_W1TC_ADDRESS 0x24
+#define GPIO_PIN0_ADDRESS 0x28
+#define GPIO_SIGMA_DELTA_ADDRESS 0x68
+
+#define GPIO_ID_PIN0 0
+#define GPIO_ID_PIN(n) (GPIO_ID_PIN0 + (n))
+#define GPIO_PIN_PAD_DRIVER_S 2
+#define GPIO_PIN_PAD_DRIVER_SET(x) (((x) & 1) << GPIO_PIN_PAD_DRIVER_S)
+#define GPIO_PAD_DRIVER_ENABLE 1
+#define GPIO_PAD_DRIVER_DISABLE 0
+
+#define FRC1_LOAD_ADDRESS 0x00
+#define FRC1_COUNT_ADDRESS 0x04
+#define FRC1_CTRL_ADDRESS 0x08
+#define FRC1_INT_ADDRESS 0x0c
+
+#define RTC_GPIO_OUT (PERIPHS_RTC_BASEADDR + 0x068)
+#define RTC_GPIO_ENABLE (PERIPHS_RTC_BASEADDR + 0x074)
+#define RTC_GPIO_IN_DATA (PERIPHS_RTC_BASEADDR + 0x08c)
+#define RTC_GPIO_CONF (PERIPHS_RTC_BASEADDR + 0x090)
+#define PAD_XPD_DCDC_CONF (PERIPHS_RTC_BASEADDR + 0x0a0)
+
+#define PERIPHS_IO_MUX_FUNC 0x13
+#define PERIPHS_IO_MUX_FUNC_S 4
+#define PERIPHS_IO_MUX_PULLUP BIT(7)
+
+#define PERIPHS_IO_MUX_MTDI_U (PERIPHS_IO_MUX + 0x04)
+#define PERIPHS_IO_MUX_MTCK_U (PERIPHS_IO_MUX + 0x08)
+#define PERIPHS_IO_MUX_MTMS_U (PERIPHS_IO_MUX + 0x0c)
+#define PERIPHS_IO_MUX_MTDO_U (PERIPHS_IO_MUX + 0x10)
+#define PERIPHS_IO_MUX_U0RXD_U (PERIPHS_IO_MUX + 0x14)
+#define PERIPHS_IO_MUX_U0TXD_U (PERIPHS_IO_MUX + 0x18)
+#define PERIPHS_IO_MUX_SD_CLK_U (PERIPHS_IO_MUX + 0x1c)
+#define PERIPHS_IO_MUX_SD_DATA0_U (PERIPHS_IO_MUX + 0x20)
+#define PERIPHS_IO_MUX_SD_DATA1_U (PERIPHS_IO_MUX + 0x24)
+#define PERIPHS_IO_MUX_SD_DATA2_U (PERIPHS_IO_MUX + 0x28)
+#define PERIPHS_IO_MUX_SD_DATA3_U (PERIPHS_IO_MUX + 0x2c)
+#define PERIPHS_IO_MUX_SD_CMD_U (PERIPHS_IO_MUX + 0x30)
+#define PERIPHS_IO_MUX_GPIO0_U (PERIPHS_IO_MUX + 0x34)
+#define PERIPHS_IO_MUX_GPIO2_U (PERIPHS_IO_MUX + 0x38)
+#define PERIPHS_IO_MUX_GPIO4_U (PERIPHS_IO_MUX + 0x3c)
+#define PERIPHS_IO_MUX_GPIO5_U (PERIPHS_IO_MUX + 0x40)
+
+#define FUNC_GPIO0 0
+#define FUNC_GPIO1 3
+#define FUNC_GPIO2 0
+#define FUNC_GPIO3 3
+#define FUNC_GPIO4 0
+#define FUNC_GPIO5 0
+#define FUNC_GPIO9 3
+#define FUNC_GPIO10 3
+#define FUNC_GPIO12 3
+#define FUNC_GPIO13 3
+#define FUNC_GPIO14 3
+#define FUNC_GPIO15 3
+#define FUNC_U0TXD 0
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef ets_sys_h
+#define ets_sys_h
+
+// host build: minimal stand-in for the sdk's ets_sys.h
+
+#include <c_types.h>
+#include <eagle_soc.h>
+
+typedef void ETSTimerFunc(void *);
+
+typedef struct _ETSTIMER_
+{
+	struct _ETSTIMER_	*timer_next;
+	uint32_t			timer_expire;
+	uint32_t			timer_period;
+	ETSTimerFunc		*timer_func;
+	void				*timer_arg;
+} ETSTimer;
+
+typedef uint32_t ETSSignal;
+typedef uint32_t ETSParam;
+
+typedef struct
+{
+	ETSSignal	sig;
+	ETSParam	par;
+} ETSEvent;
+
+typedef void (*ETSTask)(ETSEvent *);
+
+#define ETS_GPIO_INUM 4
+#define ETS_UART_INUM 5
+#define ETS_FRC_TIMER1_INUM 9
+
+// the xtensa INTENABLE special register, kept by host/sdk.c
+
+uint32_t host_intenable(void);
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef ip_addr_h
+#define ip_addr_h
+
+// host build: minimal stand-in for lwip's ip_addr.h
+
+#include <c_types.h>
+
+typedef struct ip_addr
+{
+	uint32_t addr;
+} ip_addr_t;
+
+struct ip_info
+{
+	struct ip_addr ip;
+	struct ip_addr netmask;
+	struct ip_addr gw;
+};
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef mem_h
+#define mem_h
+
+// host build: the sdk's heap wrappers are not used by the firmware
+
+#endif
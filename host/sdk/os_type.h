@@ -0,0 +1,14 @@
+#ifndef os_type_h
+#define os_type_h
+
+// host build: minimal stand-in for the sdk's os_type.h
+
+#include <ets_sys.h>
+
+typedef ETSEvent		os_event_t;
+typedef ETSSignal		os_signal_t;
+typedef ETSParam		os_param_t;
+typedef ETSTimer		os_timer_t;
+typedef ETSTimerFunc	os_timer_func_t;
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef osapi_h
+#define osapi_h
+
+// host build: minimal stand-in for the sdk's osapi.h
+
+#include <c_types.h>
+#include <os_type.h>
+#include <string.h>
+
+#define os_delay_us ets_delay_us
+#define os_memset memset
+#define os_memcpy memcpy
+#define os_strlen strlen
+#define os_strcmp strcmp
+
+// newlib declares this one, glibc doesn't
+
+size_t strlcpy(char *, const char *, size_t);
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef user_interface_h
+#define user_interface_h
+
+// host build: minimal stand-in for the sdk's user_interface.h
+
+#include <c_types.h>
+#include <os_type.h>
+#include <ip_addr.h>
+#include <ets_sys.h>
+
+#define USER_TASK_PRIO_0 0
+#define USER_TASK_PRIO_1 1
+#define USER_TASK_PRIO_2 2
+
+uint32	system_get_time(void);
+uint16	system_adc_read(void);
+void	system_restart(void);
+void	system_soft_wdt_feed(void);
+bool	system_os_post(uint8 prio, os_signal_t signal, os_param_t parameter);
+
+#endif
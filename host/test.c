@@ -0,0 +1,12 @@
+#include "host.h"
+
+int main(void)
+{
+	test_io_sim();
+	test_config_arena();
+	test_util();
+	test_sensor();
+	test_debounce();
+
+	return(host_report());
+}
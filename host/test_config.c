@@ -0,0 +1,338 @@
+#include "host.h"
+#include "config.h"
+
+#include <spi_flash.h>
+
+#include <string.h>
+
+// config arena
+
+string_new(static, value, 512);
+
+static bool_t config_string_is(const char *id, int index1, int index2, const char *expected)
+{
+	string_clear(&value);
+
+	if(!config_get_string(id, index1, index2, &value))
+		return(false);
+
+	return(string_match(&value, expected));
+}
+
+static bool_t config_int_is(const char *id, int index1, int index2, int expected)
+{
+	int current;
+
+	if(!config_get_int(id, index1, index2, &current))
+		return(false);
+
+	return(current == expected);
+}
+
+static bool_t config_set_cstring(const char *id, int index1, int index2, const char *src)
+{
+	string_clear(&value);
+	string_cat_strptr(&value, src);
+
+	return(config_set_string(id, index1, index2, &value, 0, -1));
+}
+
+static void test_arena_values(void)
+{
+	char long_value[201];
+	uint8_t blob[12], blob_read[12];
+	int current;
+
+	host_reset();
+
+	check(!config_get_int("flags", -1, -1, &current));
+
+	check(config_set_int("flags", -1, -1, 5));
+	check(config_set_int("io.%u.%u.mode", 2, 3, -7));
+	check(config_int_is("flags", -1, -1, 5));
+	check(config_int_is("io.2.3.mode", -1, -1, -7));
+	check(config_string_is("io.%u.%u.mode", 2, 3, "-7"));
+	check(!config_get_int("io.%u.%u.mode", 3, 2, &current));
+
+	// strings aren't truncated anymore, non canonical numbers stay strings
+
+	memset(long_value, 'x', sizeof(long_value) - 1);
+	long_value[sizeof(long_value) - 1] = '\0';
+
+	check(config_set_cstring("wlan.client.ssid", -1, -1, long_value));
+	check(config_string_is("wlan.client.ssid", -1, -1, long_value));
+	check(config_set_cstring("ntp.tz", -1, -1, "0012"));
+	check(config_string_is("ntp.tz", -1, -1, "0012"));
+	check(config_int_is("ntp.tz", -1, -1, 12));
+
+	// replacing an entry with a shorter or longer one keeps the others intact
+
+	check(config_set_cstring("wlan.client.ssid", -1, -1, "short"));
+	check(config_string_is("wlan.client.ssid", -1, -1, "short"));
+	check(config_set_cstring("flags", -1, -1, "now a string value"));
+	check(config_string_is("flags", -1, -1, "now a string value"));
+	check(config_int_is("io.2.3.mode", -1, -1, -7));
+	check(config_string_is("ntp.tz", -1, -1, "0012"));
+
+	// blobs only come back with the right length and never as an int
+
+	memset(blob, 0xa5, sizeof(blob));
+	blob[0] = 0;
+	check(config_set_blob("io.%u.%u", 4, 1, blob, sizeof(blob)));
+	check(config_get_blob("io.%u.%u", 4, 1, blob_read, sizeof(blob_read)));
+	check(!memcmp(blob, blob_read, sizeof(blob)));
+	check(!config_get_blob("io.%u.%u", 4, 1, blob_read, sizeof(blob_read) - 1));
+	check(!config_get_int("io.%u.%u", 4, 1, &current));
+
+	// limits
+
+	memset(long_value, 'k', 64);
+	long_value[64] = '\0';
+	check(!config_set_int(long_value, -1, -1, 1));
+	long_value[63] = '\0';
+	check(config_set_int(long_value, -1, -1, 1));
+	check(config_int_is(long_value, -1, -1, 1));
+
+	string_clear(&value);
+
+	while(string_length(&value) < 256)
+		string_append(&value, 'v');
+
+	check(!config_set_string("long", -1, -1, &value, 0, -1));
+	check(config_set_string("long", -1, -1, &value, 0, 255));
+}
+
+static void test_arena_delete(void)
+{
+	host_reset();
+
+	check(config_set_int("io.%u.%u.mode", 1, 2, 1));
+	check(config_set_int("io.%u.%u.llmode", 1, 2, 2));
+	check(config_set_int("io.%u.%u.mode", 1, 20, 3));
+	check(config_set_int("io.%u.%u.mode", 1, 3, 4));
+
+	check(config_delete("io.%u.%u.", 1, 2, true) == 2);
+	check(!config_int_is("io.%u.%u.mode", 1, 2, 1));
+	check(!config_int_is("io.%u.%u.llmode", 1, 2, 2));
+	check(config_int_is("io.%u.%u.mode", 1, 20, 3));
+	check(config_int_is("io.%u.%u.mode", 1, 3, 4));
+
+	check(config_delete("io.%u.%u.mode", 1, 3, false) == 1);
+	check(config_delete("io.%u.%u.mode", 1, 3, false) == 0);
+	check(config_int_is("io.%u.%u.mode", 1, 20, 3));
+
+	check(config_delete("io.", -1, -1, true) == 1);
+	check(!config_int_is("io.%u.%u.mode", 1, 20, 3));
+
+	// the index is rebuilt, new entries are still found
+
+	check(config_set_int("io.%u.%u.mode", 1, 2, 5));
+	check(config_int_is("io.%u.%u.mode", 1, 2, 5));
+}
+
+static void test_arena_full(void)
+{
+	int entry, stored, current;
+
+	host_reset();
+
+	// the entry limit
+
+	for(entry = 0, stored = 0; entry < 120; entry++)
+		if(config_set_int("key.%u", entry, -1, entry))
+			stored = entry + 1;
+
+	check(stored == 99);
+
+	for(entry = 0; entry < stored; entry++)
+		check(config_int_is("key.%u", entry, -1, entry));
+
+	check(!config_get_int("key.%u", stored, -1, &current));
+
+	// the arena size, a refused update leaves the old value
+
+	host_reset();
+
+	string_clear(&value);
+
+	while(string_length(&value) < 200)
+		string_append(&value, 's');
+
+	for(entry = 0, stored = 0; entry < 30; entry++)
+		if(config_set_string("string.%u", entry, -1, &value, 0, -1))
+			stored = entry + 1;
+
+	check((stored > 10) && (stored < 30));
+
+	for(entry = 0; entry < stored; entry++)
+		check(config_get_string("string.%u", entry, -1, &value));
+
+	check(config_set_int("string.%u", 0, -1, 1));
+	check(config_int_is("string.%u", 0, -1, 1));
+}
+
+static void test_arena_persist(void)
+{
+	uint8_t blob[12], blob_read[12];
+
+	host_reset();
+
+	memset(blob, 0x5a, sizeof(blob));
+
+	check(config_set_int("flags", -1, -1, 3));
+	check(config_set_cstring("wlan.client.ssid", -1, -1, "a string longer than the old thirty one chars"));
+	check(config_set_blob("io.%u.%u", 0, 4, blob, sizeof(blob)));
+	check(config_write() > 0);
+
+	// changes after the write are appended to the log
+
+	check(config_set_int("flags", -1, -1, 4));
+	check(config_delete("wlan.client.ssid", -1, -1, false) == 1);
+	check(config_write() > 0);
+
+	check(config_set_int("flags", -1, -1, 99));
+	check(config_read());
+
+	check(config_int_is("flags", -1, -1, 4));
+	check(!config_string_is("wlan.client.ssid", -1, -1, "a string longer than the old thirty one chars"));
+	check(config_get_blob("io.%u.%u", 0, 4, blob_read, sizeof(blob_read)));
+	check(!memcmp(blob, blob_read, sizeof(blob)));
+}
+
+// compaction alternates between the log sectors and never touches the sectors around them
+
+static void test_arena_sectors(void)
+{
+	int sector;
+	bool_t ok;
+
+	host_reset();
+
+	check(config_set_int("flags", -1, -1, 1));
+	check(config_write() > 0);
+	check(host_flash_erases(USER_CONFIG_LOG_SECTOR + 0) == 1);
+	check(host_flash_erases(USER_CONFIG_LOG_SECTOR + 1) == 0);
+
+	check(config_delete("flags", -1, -1, false) == 1);
+	check(config_set_int("flags", -1, -1, 2));
+	check(config_write() > 0);
+	check(host_flash_erases(USER_CONFIG_LOG_SECTOR + 0) == 1);
+	check(host_flash_erases(USER_CONFIG_LOG_SECTOR + 1) == 1);
+
+	check(config_delete("flags", -1, -1, false) == 1);
+	check(config_set_int("flags", -1, -1, 3));
+	check(config_write() > 0);
+	check(host_flash_erases(USER_CONFIG_LOG_SECTOR + 0) == 2);
+	check(host_flash_erases(USER_CONFIG_LOG_SECTOR + 1) == 1);
+
+	for(sector = 0, ok = true; sector < 0x80; sector++)
+		if(((sector < USER_CONFIG_LOG_SECTOR) || (sector >= (USER_CONFIG_LOG_SECTOR + USER_CONFIG_LOG_SECTORS))) &&
+				host_flash_erases(sector))
+			ok = false;
+
+	check(ok);
+	check(USER_CONFIG_SECTOR < (RFCAL_ADDRESS / SPI_FLASH_SEC_SIZE));
+	check((USER_CONFIG_LOG_SECTOR + USER_CONFIG_LOG_SECTORS) <= (RFCAL_ADDRESS / SPI_FLASH_SEC_SIZE));
+
+	check(config_read());
+	check(config_int_is("flags", -1, -1, 3));
+}
+
+// an append cut off after the crc word, with the type byte still erased, isn't mistaken for the end of the log
+
+static void test_arena_torn_append(void)
+{
+	static uint8_t sector[SPI_FLASH_SEC_SIZE];
+	static const uint8_t crc_only[4] = { 0x12, 0x34, 0x56, 0x78 };
+	unsigned int end;
+
+	host_reset();
+
+	check(config_set_int("flags", -1, -1, 1));
+	check(config_write() > 0);
+	check(config_set_int("flags", -1, -1, 2));
+	check(config_write() > 0);
+
+	// the first write compacted into log sector 0, find the end of the appended records
+
+	check(spi_flash_read(USER_CONFIG_LOG_SECTOR * SPI_FLASH_SEC_SIZE, sector, sizeof(sector)) == SPI_FLASH_RESULT_OK);
+
+	for(end = sizeof(sector); (end > 0) && (sector[end - 1] == 0xff); end--)
+		;
+
+	end = (end + 3) & ~3U;
+
+	check(spi_flash_write(USER_CONFIG_LOG_SECTOR * SPI_FLASH_SEC_SIZE + end, crc_only, sizeof(crc_only)) == SPI_FLASH_RESULT_OK);
+
+	check(config_read());
+	check(config_int_is("flags", -1, -1, 2));
+
+	check(config_set_int("flags", -1, -1, 3));
+	check(config_write() > 0);
+
+	check(config_read());
+	check(config_int_is("flags", -1, -1, 3));
+}
+
+// config-export output merged back in through config-import
+
+static void test_arena_import(void)
+{
+	string_new(static, exported, 1024);
+	string_new(static, malformed, 64);
+	uint8_t blob[12], blob_read[12];
+	unsigned int imported;
+	int ix;
+
+	host_reset();
+
+	for(ix = 0; ix < (int)sizeof(blob); ix++)
+		blob[ix] = ix * 21;
+
+	check(config_set_int("flags", -1, -1, 7));
+	check(config_set_cstring("wlan.client.ssid", -1, -1, "with spaces = and equals"));
+	check(config_set_cstring("leading.zeroes", -1, -1, "0012"));
+	check(config_set_blob("io.%u.%u", 0, 4, blob, sizeof(blob)));
+
+	string_clear(&exported);
+	string_cat(&exported, "cim ");
+	config_export(&exported);
+
+	host_reset();
+	check(!config_int_is("flags", -1, -1, 7));
+
+	check(config_import(&exported, 4, &imported));
+	check(imported == 4);
+	check(config_int_is("flags", -1, -1, 7));
+	check(config_string_is("wlan.client.ssid", -1, -1, "with spaces = and equals"));
+	check(config_string_is("leading.zeroes", -1, -1, "0012"));
+	check(config_get_blob("io.%u.%u", 0, 4, blob_read, sizeof(blob_read)));
+	check(!memcmp(blob, blob_read, sizeof(blob)));
+
+	// a single entry on the command line and crlf line ends
+
+	string_clear(&malformed);
+	string_cat(&malformed, "cim flags=8\r\nother=x\r\n");
+	check(config_import(&malformed, 4, &imported) && (imported == 2));
+	check(config_int_is("flags", -1, -1, 8));
+	check(config_string_is("other", -1, -1, "x"));
+
+	string_clear(&malformed);
+	string_cat(&malformed, "cim flags=9\nno separator\n");
+	check(!config_import(&malformed, 4, &imported) && (imported == 1));
+
+	string_clear(&malformed);
+	string_cat(&malformed, "cim io.0.5=blob:123\n");
+	check(!config_import(&malformed, 4, &imported));
+}
+
+void test_config_arena(void)
+{
+	test_arena_values();
+	test_arena_delete();
+	test_arena_full();
+	test_arena_persist();
+	test_arena_sectors();
+	test_arena_torn_append();
+	test_arena_import();
+}
@@ -0,0 +1,162 @@
+#include "host.h"
+#include "io_debounce.h"
+
+#include <string.h>
+
+// integrator debounce
+
+static int samples_until_change(io_debounce_t *debounce, uint32_t input, uint32_t pins, int limit)
+{
+	int sample;
+
+	for(sample = 1; sample <= limit; sample++)
+		if(io_debounce_sample(debounce, input) & pins)
+			return(sample);
+
+	return(-1);
+}
+
+static void test_debounce_samples(void)
+{
+	io_debounce_t debounce;
+	int samples;
+	bool_t ok;
+
+	// without io_debounce_pin every pin follows its input right away
+
+	io_debounce_init(&debounce, 0x0000);
+	check(io_debounce_sample(&debounce, 0x8001) == 0x8001);
+	check(debounce.state == 0x8001);
+	check(!io_debounce_busy(&debounce));
+	check(io_debounce_sample(&debounce, 0x8001) == 0);
+
+	// a pin changes after exactly its number of consecutive differing samples,
+	// also for counts that need the upper planes
+
+	for(samples = 1, ok = true; samples <= io_debounce_max_samples; samples++)
+	{
+		io_debounce_init(&debounce, 0x0000);
+		io_debounce_pin(&debounce, 3, samples, false);
+
+		if(samples_until_change(&debounce, 1 << 3, 1 << 3, io_debounce_max_samples + 1) != samples)
+			ok = false;
+
+		if(samples_until_change(&debounce, 0, 1 << 3, io_debounce_max_samples + 1) != samples)
+			ok = false;
+	}
+
+	check(ok);
+
+	// out of range sample counts are clamped
+
+	io_debounce_init(&debounce, 0x0000);
+	io_debounce_pin(&debounce, 0, 0, false);
+	io_debounce_pin(&debounce, 1, io_debounce_max_samples + 100, false);
+	check(samples_until_change(&debounce, 0x0003, 0x0001, 1) == 1);
+	check(samples_until_change(&debounce, 0x0003, 0x0002, 1000) == (io_debounce_max_samples - 1));
+}
+
+static void test_debounce_glitch(void)
+{
+	io_debounce_t debounce;
+	int sample;
+
+	io_debounce_init(&debounce, 0x0000);
+	io_debounce_pin(&debounce, 5, 4, false);
+
+	// a glitch shorter than the debounce time restarts the count
+
+	check(io_debounce_sample(&debounce, 1 << 5) == 0);
+	check(io_debounce_sample(&debounce, 1 << 5) == 0);
+	check(io_debounce_sample(&debounce, 1 << 5) == 0);
+	check(io_debounce_busy(&debounce));
+	check(io_debounce_sample(&debounce, 0) == 0);
+	check(!io_debounce_busy(&debounce));
+
+	for(sample = 0; sample < 3; sample++)
+		check(io_debounce_sample(&debounce, 1 << 5) == 0);
+
+	check(io_debounce_sample(&debounce, 1 << 5) == (1 << 5));
+	check(debounce.state == (1 << 5));
+	check(!io_debounce_busy(&debounce));
+}
+
+static void test_debounce_pins(void)
+{
+	io_debounce_t debounce;
+	uint32_t changed, seen;
+	int sample;
+
+	// pins are independent, each with its own sample count
+
+	io_debounce_init(&debounce, 0xffff0000);
+	io_debounce_pin(&debounce, 0, 2, false);
+	io_debounce_pin(&debounce, 7, 100, false);
+	io_debounce_pin(&debounce, 31, 20, true);
+
+	for(sample = 1, seen = 0; sample <= 100; sample++)
+	{
+		changed = io_debounce_sample(&debounce, 0x7fff0081);
+
+		if(changed & (1 << 0))
+			check(sample == 2);
+
+		if(changed & (1 << 7))
+			check(sample == 100);
+
+		if(changed & (1U << 31))
+			check(sample == 20);
+
+		seen |= changed;
+	}
+
+	check(seen == 0x80000081);
+	check(debounce.state == 0x7fff0081);
+
+	// io_debounce_pin sets the state and restarts the count
+
+	io_debounce_init(&debounce, 0x0000);
+	io_debounce_pin(&debounce, 2, 3, false);
+	io_debounce_sample(&debounce, 1 << 2);
+	io_debounce_sample(&debounce, 1 << 2);
+	io_debounce_pin(&debounce, 2, 3, true);
+	check(!io_debounce_busy(&debounce));
+	check(io_debounce_sample(&debounce, 1 << 2) == 0);
+}
+
+static void test_debounce_counts(void)
+{
+	io_config_pin_entry_t pin_config;
+
+	memset(&pin_config, 0, sizeof(pin_config));
+	pin_config.llmode = io_pin_ll_counter;
+
+	check(io_debounce_counts(&pin_config, false));
+	check(!io_debounce_counts(&pin_config, true));
+
+	pin_config.flags.rising = 1;
+	check(!io_debounce_counts(&pin_config, false));
+	check(io_debounce_counts(&pin_config, true));
+
+	pin_config.flags.falling = 1;
+	check(io_debounce_counts(&pin_config, false));
+	check(io_debounce_counts(&pin_config, true));
+
+	pin_config.speed = 1;
+	check(io_debounce_samples(&pin_config) == 1);
+	pin_config.speed = 25;
+	check(io_debounce_samples(&pin_config) == 3);
+	pin_config.speed = io_debounce_max_ms;
+	check(io_debounce_samples(&pin_config) == io_debounce_max_samples);
+
+	pin_config.llmode = io_pin_ll_input_digital;
+	check(io_debounce_samples(&pin_config) == 1);
+}
+
+void test_debounce(void)
+{
+	test_debounce_samples();
+	test_debounce_glitch();
+	test_debounce_pins();
+	test_debounce_counts();
+}
@@ -0,0 +1,529 @@
+#include "host.h"
+#include "config.h"
+#include "io.h"
+#include "io_gpio.h"
+#include "io_sim.h"
+#include "io_mcp.h"
+#include "io_debounce.h"
+#include "stats.h"
+
+#include <string.h>
+
+// io engine scenarios on the simulated io
+
+string_new(static, reply, 4096);
+
+static void sim_setup(void)
+{
+	host_reset();
+	config_set_int("sim.enable", -1, -1, 1);
+	io_init();
+}
+
+static void sim_input(int pin, bool_t value)
+{
+	string_new(static, command, 64);
+
+	string_clear(&command);
+	string_format(&command, "io-sim-input %d %d", pin, value);
+	check(host_command(application_function_io_sim_input, string_to_ptr(&command), &reply) == app_action_normal);
+}
+
+static void test_timer(void)
+{
+	int tick;
+
+	sim_setup();
+
+	check(host_command(application_function_io_mode, "io-mode 4 0 timer up 100", &reply) == app_action_normal);
+	check(host_command(application_function_io_set_flag, "io-set-flag 4 0 repeat", &reply) == app_action_normal);
+	check(host_read(io_id_sim, 0) == 0);
+
+	check(host_command(application_function_io_trigger, "io-trigger 4 0 on", &reply) == app_action_normal);
+
+	// the edges come from the timer queue, not from the 10 ms tick, so they're exact
+
+	host_advance(99999);
+	check(host_read(io_id_sim, 0) == 0);
+	host_advance(1);
+	check(host_read(io_id_sim, 0) == 1);
+	host_advance(100000);
+	check(host_read(io_id_sim, 0) == 0);
+
+	// repeating pulses don't drift, also not when driven by the periodic ticks
+
+	for(tick = 0; tick < 100; tick++)
+		host_tick();
+
+	check(host_read(io_id_sim, 0) == 0);
+	host_advance(100000);
+	check(host_read(io_id_sim, 0) == 1);
+
+	check(host_command(application_function_io_trigger, "io-trigger 4 0 off", &reply) == app_action_normal);
+	host_advance(1000000);
+	check(host_read(io_id_sim, 0) == 1);
+
+	// one shot
+
+	check(host_command(application_function_io_clear_flag, "io-clear-flag 4 0 repeat", &reply) == app_action_normal);
+	check(host_command(application_function_io_trigger, "io-trigger 4 0 on", &reply) == app_action_normal);
+	check(host_read(io_id_sim, 0) == 0);
+	host_advance(100000);
+	check(host_read(io_id_sim, 0) == 1);
+	host_advance(1000000);
+	check(host_read(io_id_sim, 0) == 1);
+}
+
+static void test_timer_us(void)
+{
+	sim_setup();
+
+	check(host_command(application_function_io_mode, "io-mode 4 1 timer up 250us", &reply) == app_action_normal);
+	check(host_command(application_function_io_set_flag, "io-set-flag 4 1 repeat", &reply) == app_action_normal);
+	check(host_command(application_function_io_trigger, "io-trigger 4 1 on", &reply) == app_action_normal);
+
+	host_advance(249);
+	check(host_read(io_id_sim, 1) == 0);
+	host_advance(1);
+	check(host_read(io_id_sim, 1) == 1);
+	host_advance(250);
+	check(host_read(io_id_sim, 1) == 0);
+
+	check(host_command(application_function_io_mode, "io-mode 4 1", &reply) == app_action_normal);
+	check(strstr(string_to_ptr(&reply), "speed: 250 us") != (char *)0);
+
+	// an explicit ms suffix, the unit is reset by the new mode
+
+	check(host_command(application_function_io_mode, "io-mode 4 1 timer up 2ms", &reply) == app_action_normal);
+	check(host_command(application_function_io_trigger, "io-trigger 4 1 on", &reply) == app_action_normal);
+	host_advance(1999);
+	check(host_read(io_id_sim, 1) == 0);
+	host_advance(1);
+	check(host_read(io_id_sim, 1) == 1);
+
+	check(host_command(application_function_io_mode, "io-mode 4 1", &reply) == app_action_normal);
+	check(strstr(string_to_ptr(&reply), "speed: 2 ms") != (char *)0);
+
+	check(host_command(application_function_io_mode, "io-mode 4 1 timer up 10s", &reply) == app_action_error);
+	check(host_command(application_function_io_mode, "io-mode 4 1 timer up us", &reply) == app_action_error);
+	check(host_command(application_function_io_mode, "io-mode 4 1 timer up 0us", &reply) == app_action_error);
+}
+
+static void test_trigger(void)
+{
+	sim_setup();
+
+	check(host_command(application_function_io_mode, "io-mode 4 2 outputd", &reply) == app_action_normal);
+	check(host_command(application_function_io_mode, "io-mode 4 1 trigger 0 4 2 up", &reply) == app_action_normal);
+	check(host_read(io_id_sim, 2) == 0);
+
+	sim_input(1, 1);
+	host_ticks(2);
+	check(host_read(io_id_sim, 2) == 0);
+
+	sim_input(1, 0);
+	host_tick();
+	check(host_read(io_id_sim, 2) == 1);
+	check(host_read(io_id_sim, 1) == 0);
+
+	// trigger the trigger pin directly, it fires on the next deferred run
+
+	check(host_command(application_function_io_mode, "io-mode 4 3 trigger 0 4 2 down", &reply) == app_action_normal);
+	check(host_command(application_function_io_trigger, "io-trigger 4 3 up", &reply) == app_action_normal);
+	host_tick();
+	check(host_read(io_id_sim, 2) == 0);
+}
+
+static void test_counter(void)
+{
+	int ix;
+
+	sim_setup();
+
+	check(host_command(application_function_io_mode, "io-mode 4 5 counter 30", &reply) == app_action_normal);
+	check(host_read(io_id_sim, 5) == 0);
+
+	// counts on the falling edge, after three stable samples
+
+	for(ix = 0; ix < 5; ix++)
+	{
+		sim_input(5, 1);
+		host_ticks(3);
+		sim_input(5, 0);
+		host_ticks(2);
+		check(host_read(io_id_sim, 5) == ix);
+		host_tick();
+		check(host_read(io_id_sim, 5) == (ix + 1));
+	}
+
+	// glitches shorter than the debounce time are ignored
+
+	sim_input(5, 1);
+	host_ticks(2);
+	sim_input(5, 0);
+	host_ticks(10);
+	check(host_read(io_id_sim, 5) == 5);
+
+	// rising edge instead, changing a flag reinitialises the pin
+
+	check(host_command(application_function_io_set_flag, "io-set-flag 4 5 rising", &reply) == app_action_normal);
+	check(host_read(io_id_sim, 5) == 0);
+	sim_input(5, 1);
+	host_ticks(3);
+	check(host_read(io_id_sim, 5) == 1);
+	sim_input(5, 0);
+	host_ticks(3);
+	check(host_read(io_id_sim, 5) == 1);
+
+	check(host_command(application_function_io_write, "io-write 4 5 0", &reply) == app_action_normal);
+	check(host_read(io_id_sim, 5) == 0);
+}
+
+static void test_analog_ramp(void)
+{
+	int tick, value, previous, top;
+
+	sim_setup();
+
+	check(host_command(application_function_io_mode, "io-mode 4 6 outputa 10 1000 1000", &reply) == app_action_normal);
+	check(host_read(io_id_sim, 6) == 0);
+
+	check(host_command(application_function_io_trigger, "io-trigger 4 6 on", &reply) == app_action_normal);
+
+	// ramp up by 10% per tick from the lower bound, then back down to off
+
+	for(tick = 0, previous = 0, top = 0; tick < 200; tick++)
+	{
+		host_tick();
+		value = host_read(io_id_sim, 6);
+
+		if(!top)
+		{
+			check(value > previous);
+
+			if(value == 1000)
+				top = tick;
+		}
+		else
+			check(value < previous);
+
+		previous = value;
+
+		if(top && (value == 0))
+			break;
+	}
+
+	check(top > 0);
+	check(value == 0);
+
+	// with repeat it keeps bouncing between the bounds
+
+	check(host_command(application_function_io_set_flag, "io-set-flag 4 6 repeat", &reply) == app_action_normal);
+	check(host_command(application_function_io_trigger, "io-trigger 4 6 on", &reply) == app_action_normal);
+	host_ticks(1000);
+	check(host_read(io_id_sim, 6) >= 10);
+
+	check(host_command(application_function_io_trigger, "io-trigger 4 6 off", &reply) == app_action_normal);
+	value = host_read(io_id_sim, 6);
+	host_ticks(10);
+	check(host_read(io_id_sim, 6) == value);
+}
+
+// ramps on several gpio pwm channels share one phase set rebuild per tick
+
+static void test_gpio_analog_ramp(void)
+{
+	int builds;
+
+	host_reset();
+	io_init();
+
+	check(host_command(application_function_io_mode, "io-mode 0 4 outputa 1000 60000 1000", &reply) == app_action_normal);
+	check(host_command(application_function_io_mode, "io-mode 0 5 outputa 1000 60000 1000", &reply) == app_action_normal);
+	check(host_command(application_function_io_mode, "io-mode 0 12 outputa 1000 60000 1000", &reply) == app_action_normal);
+
+	check(host_command(application_function_io_trigger, "io-trigger 0 4 on", &reply) == app_action_normal);
+	check(host_command(application_function_io_trigger, "io-trigger 0 5 on", &reply) == app_action_normal);
+	check(host_command(application_function_io_trigger, "io-trigger 0 12 on", &reply) == app_action_normal);
+	host_tick();
+
+	builds = stat_pwm_phase_builds;
+	host_ticks(10);
+	check((stat_pwm_phase_builds - builds) == 10);
+	check(host_read(io_id_gpio, 4) > 1000);
+	check(host_read(io_id_gpio, 4) == host_read(io_id_gpio, 12));
+}
+
+// gpio counters count from the edge interrupt, the debounce time is a lockout in us
+
+static void test_gpio_counter(void)
+{
+	host_reset();
+	io_init();
+
+	check(host_command(application_function_io_mode, "io-mode 0 4 counter 5", &reply) == app_action_normal);
+	check(host_read(io_id_gpio, 4) == 0);
+
+	host_gpio_input(4, true);
+	host_advance(100);
+	host_gpio_input(4, false);
+	check(host_read(io_id_gpio, 4) == 1);
+
+	// contact bounce within 5 ms after the counted edge
+
+	host_advance(1000);
+	host_gpio_input(4, true);
+	host_advance(1000);
+	host_gpio_input(4, false);
+	host_tick();
+	check(host_read(io_id_gpio, 4) == 1);
+
+	// pulses much shorter than the 10 ms tick still count
+
+	host_gpio_input(4, true);
+	host_advance(200);
+	host_gpio_input(4, false);
+	host_advance(5000);
+	host_gpio_input(4, true);
+	host_advance(200);
+	host_gpio_input(4, false);
+	check(host_read(io_id_gpio, 4) == 3);
+
+	// the debounce time is only limited by the integrator on ios without edge timing
+
+	check(host_command(application_function_io_mode, "io-mode 0 4 counter 10000", &reply) == app_action_normal);
+	check(host_command(application_function_io_mode, "io-mode 0 4 counter -1", &reply) == app_action_error);
+}
+
+// frequency and pulse width on the gpio, from the edge interrupt
+
+static void test_gpio_edge_timing(void)
+{
+	int edge;
+
+	host_reset();
+	io_init();
+
+	check(host_command(application_function_io_mode, "io-mode 0 12 frequency 100", &reply) == app_action_normal);
+	check(host_command(application_function_io_mode, "io-mode 0 13 pulse high 50", &reply) == app_action_normal);
+
+	// 1 kHz on gpio 12 for a few gate times, with the periodic run every 10 ms as usual
+
+	for(edge = 1; edge <= 300; edge++)
+	{
+		host_gpio_input(12, true);
+		host_advance(500);
+		host_gpio_input(12, false);
+		host_advance(500);
+
+		if((edge % 10) == 0)
+			host_tick_now();
+	}
+
+	check((host_read(io_id_gpio, 12) >= 990) && (host_read(io_id_gpio, 12) <= 1010));
+
+	// 300 us high, 700 us low on gpio 13
+
+	host_gpio_input(13, true);
+	host_advance(300);
+	host_gpio_input(13, false);
+	host_advance(700);
+	host_gpio_input(13, true);
+	check(host_read(io_id_gpio, 13) == 300);
+
+	// the width reads 0 once the signal stops for longer than the timeout
+
+	host_ticks(4);
+	check(host_read(io_id_gpio, 13) == 300);
+	host_ticks(2);
+	check(host_read(io_id_gpio, 13) == 0);
+
+	check(host_command(application_function_io_mode, "io-mode 0 13 pulse high 5", &reply) == app_action_error);
+}
+
+// sequence step durations must fit the timer ticks in 32 bits
+
+static void test_gpio_sequence_limits(void)
+{
+	host_reset();
+	io_init();
+
+	check(host_command(application_function_gpio_sequence, "gpio-sequence add 0x0001 9", &reply) == app_action_error);
+	check(host_command(application_function_gpio_sequence, "gpio-sequence add 0x0001 858993460", &reply) == app_action_error);
+	check(host_command(application_function_gpio_sequence, "gpio-sequence add 0x0001 858993459", &reply) == app_action_normal);
+	check(host_command(application_function_gpio_sequence, "gpio-sequence save", &reply) == app_action_normal);
+
+	io_init();
+	check(host_command(application_function_gpio_sequence, "gpio-sequence", &reply) == app_action_normal);
+	check(string_match(&reply, "sequence: 1 steps, stopped\n 0: mask 0x0001, duration 858993459 us\n"));
+}
+
+// a pulse on the mcp23017 that ends before the next tick is seen through INTCAP
+
+static void test_mcp_intcap(void)
+{
+	string_new(static, command, 64);
+
+	host_reset();
+	host_i2c_attach(host_i2c_mcp, true);
+	host_mcp_input(3, true);
+	io_init();
+
+	check(host_command(application_function_io_mode, "io-mode 2 3 counter 0", &reply) == app_action_normal);
+	host_tick();
+	check(host_read(io_id_mcp_20, 3) == 0);
+
+	host_mcp_input(3, false);
+	host_mcp_input(3, true);
+	host_tick();
+	check(host_read(io_id_mcp_20, 3) == 1);
+	host_ticks(2);
+	check(host_read(io_id_mcp_20, 3) == 1);
+
+	// the integrator has a limited number of samples
+
+	string_clear(&command);
+	string_format(&command, "io-mode 2 3 counter %d", io_debounce_max_ms);
+	check(host_command(application_function_io_mode, string_to_ptr(&command), &reply) == app_action_normal);
+
+	string_clear(&command);
+	string_format(&command, "io-mode 2 3 counter %d", io_debounce_max_ms + 1);
+	check(host_command(application_function_io_mode, string_to_ptr(&command), &reply) == app_action_error);
+	check(host_command(application_function_io_mode, "io-mode 2 3 trigger 3000 4 0 up", &reply) == app_action_error);
+}
+
+// the mcp23017 interrupt line is only used when it's a gpio in inputd mode, otherwise the mcp is scanned every tick
+
+static void test_mcp_int_pin(void)
+{
+	unsigned int transactions;
+
+	host_reset();
+	host_i2c_attach(host_i2c_mcp, true);
+	io_init();
+
+	check(host_command(application_function_io_mode, "io-mode 2 3 inputd", &reply) == app_action_normal);
+	check(host_command(application_function_io_mode, "io-mode 0 5 inputd", &reply) == app_action_normal);
+	check(config_set_int("mcp.%u.int.pin", io_mcp_instance_20, -1, 5));
+	host_gpio_input(5, true);
+	io_init();
+	host_tick();
+
+	transactions = host_i2c_transactions();
+	host_ticks(10);
+	check(host_i2c_transactions() == transactions);
+
+	// an output that happens to be high would otherwise block the scan forever
+
+	check(host_command(application_function_io_mode, "io-mode 0 5 outputd", &reply) == app_action_normal);
+	io_init();
+	check(io_write_pin((string_t *)0, io_id_gpio, 5, 1) == io_ok);
+	host_tick();
+
+	transactions = host_i2c_transactions();
+	host_ticks(10);
+	check(host_i2c_transactions() > transactions);
+
+	check(config_set_int("mcp.%u.int.pin", io_mcp_instance_20, -1, 6));
+	io_init();
+	host_tick();
+
+	transactions = host_i2c_transactions();
+	host_ticks(10);
+	check(host_i2c_transactions() > transactions);
+}
+
+// the pcf8574 is only read when it has inputs or counters
+
+static void test_pcf_idle(void)
+{
+	unsigned int transactions;
+
+	host_reset();
+	host_i2c_attach(host_i2c_pcf, true);
+	io_init();
+
+	check(host_command(application_function_io_mode, "io-mode 3 0 outputd", &reply) == app_action_normal);
+	host_tick();
+
+	transactions = host_i2c_transactions();
+	host_ticks(10);
+	check(host_i2c_transactions() == transactions);
+
+	check(host_command(application_function_io_mode, "io-mode 3 1 inputd", &reply) == app_action_normal);
+	host_tick();
+
+	transactions = host_i2c_transactions();
+	host_ticks(10);
+	check(host_i2c_transactions() == (transactions + 10));
+
+	check(host_command(application_function_io_mode, "io-mode 3 1 outputd", &reply) == app_action_normal);
+	host_tick();
+
+	transactions = host_i2c_transactions();
+	host_ticks(10);
+	check(host_i2c_transactions() == transactions);
+}
+
+// stored pin configurations are checked against the io's capabilities and, for encoders, against the partner pin
+
+static void test_config_valid(void)
+{
+	io_config_pin_entry_t pin_config;
+
+	host_reset();
+	io_init();
+
+	check(host_command(application_function_io_mode, "io-mode 0 4 encoder 5", &reply) == app_action_normal);
+	check(config_get_blob("io.%u.%u", io_id_gpio, 4, &pin_config, sizeof(pin_config)));
+	check(config_get_blob("io.%u.%u", io_id_gpio, 5, &pin_config, sizeof(pin_config)));
+
+	io_init();
+	check(io_config[io_id_gpio][4].mode == io_pin_encoder);
+	check(io_config[io_id_gpio][5].mode == io_pin_encoder);
+
+	// both pins marked as primary, the pair is dropped
+
+	pin_config.shared.encoder.secondary = 0;
+	check(config_set_blob("io.%u.%u", io_id_gpio, 5, &pin_config, sizeof(pin_config)));
+	io_init();
+	check(io_config[io_id_gpio][4].mode == io_pin_disabled);
+	check(io_config[io_id_gpio][5].mode == io_pin_disabled);
+
+	// partner out of range
+
+	pin_config.shared.encoder.secondary = 1;
+	pin_config.shared.encoder.partner = max_pins_per_io;
+	check(config_set_blob("io.%u.%u", io_id_gpio, 5, &pin_config, sizeof(pin_config)));
+	io_init();
+	check(io_config[io_id_gpio][5].mode == io_pin_disabled);
+
+	// a low level mode the io can't do
+
+	memset(&pin_config, 0, sizeof(pin_config));
+	pin_config.mode = io_pin_output_digital;
+	pin_config.llmode = io_pin_ll_output_sigma_delta;
+	check(config_set_blob("io.%u.%u", io_id_sim, 0, &pin_config, sizeof(pin_config)));
+	pin_config.llmode = io_pin_ll_output_digital;
+	check(config_set_blob("io.%u.%u", io_id_sim, 1, &pin_config, sizeof(pin_config)));
+	io_init();
+	check(io_config[io_id_sim][0].mode == io_pin_disabled);
+	check(io_config[io_id_sim][1].mode == io_pin_output_digital);
+}
+
+void test_io_sim(void)
+{
+	test_timer();
+	test_timer_us();
+	test_trigger();
+	test_counter();
+	test_analog_ramp();
+	test_gpio_analog_ramp();
+	test_gpio_counter();
+	test_gpio_edge_timing();
+	test_gpio_sequence_limits();
+	test_mcp_intcap();
+	test_mcp_int_pin();
+	test_pcf_idle();
+	test_config_valid();
+}
@@ -0,0 +1,260 @@
+#include "host.h"
+#include "config.h"
+#include "i2c_sensor.h"
+
+#include <math.h>
+
+// fixed point sensor conversions against the double formulas they replaced
+
+static const struct
+{
+	uint16_t	t1;
+	int16_t		t2, t3;
+	uint16_t	p1;
+	int16_t		p2, p3, p4, p5, p6, p7, p8, p9;
+	uint8_t		h1;
+	int16_t		h2;
+	uint8_t		h3;
+	int16_t		h4, h5;
+	int8_t		h6;
+} calibration =
+{
+	27504, 26435, -1000,
+	36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000,
+	75, 362, 0, 313, 50, 30,
+};
+
+enum
+{
+	bme280_scale_temperature = 10,
+	bme280_scale_airpressure = 10,
+	bme280_scale_humidity = 100,
+	digipicco_scale_temperature = 100,
+};
+
+static void bme280_setup(void)
+{
+	static const struct
+	{
+		int				reg;
+		const void		*value;
+	} words[] =
+	{
+		{ 0x88, &calibration.t1 }, { 0x8a, &calibration.t2 }, { 0x8c, &calibration.t3 },
+		{ 0x8e, &calibration.p1 }, { 0x90, &calibration.p2 }, { 0x92, &calibration.p3 },
+		{ 0x94, &calibration.p4 }, { 0x96, &calibration.p5 }, { 0x98, &calibration.p6 },
+		{ 0x9a, &calibration.p7 }, { 0x9c, &calibration.p8 }, { 0x9e, &calibration.p9 },
+		{ 0xe1, &calibration.h2 },
+	};
+	unsigned int ix;
+	uint16_t word;
+
+	host_reset();
+	host_i2c_attach(host_i2c_bme280, true);
+
+	for(ix = 0; ix < (sizeof(words) / sizeof(*words)); ix++)
+	{
+		word = *(const uint16_t *)words[ix].value;
+		host_bme280_write(words[ix].reg + 0, word & 0xff);
+		host_bme280_write(words[ix].reg + 1, word >> 8);
+	}
+
+	host_bme280_write(0xa1, calibration.h1);
+	host_bme280_write(0xe3, calibration.h3);
+	host_bme280_write(0xe4, calibration.h4 >> 4);
+	host_bme280_write(0xe5, ((calibration.h5 & 0x0f) << 4) | (calibration.h4 & 0x0f));
+	host_bme280_write(0xe6, calibration.h5 >> 4);
+	host_bme280_write(0xe7, (uint8_t)calibration.h6);
+
+	// scale the output, so the decimals printed cover the full 1/1000 resolution
+
+	config_set_int("i2s.%u.%u.factor", 0, i2c_sensor_bme280_temperature, bme280_scale_temperature * 1000);
+	config_set_int("i2s.%u.%u.factor", 0, i2c_sensor_bme280_airpressure, bme280_scale_airpressure * 1000);
+	config_set_int("i2s.%u.%u.factor", 0, i2c_sensor_bme280_humidity, bme280_scale_humidity * 1000);
+}
+
+static void bme280_adc(int32_t adc_T, int32_t adc_P, int32_t adc_H)
+{
+	host_bme280_write(0xf7, (adc_P >> 12) & 0xff);
+	host_bme280_write(0xf8, (adc_P >> 4) & 0xff);
+	host_bme280_write(0xf9, (adc_P << 4) & 0xf0);
+	host_bme280_write(0xfa, (adc_T >> 12) & 0xff);
+	host_bme280_write(0xfb, (adc_T >> 4) & 0xff);
+	host_bme280_write(0xfc, (adc_T << 4) & 0xf0);
+	host_bme280_write(0xfd, (adc_H >> 8) & 0xff);
+	host_bme280_write(0xfe, (adc_H >> 0) & 0xff);
+}
+
+// the sensor value in its own unit, from the scaled "[value]" in the reply
+
+static bool_t sensor_value(i2c_sensor_t sensor, int scale, double *value)
+{
+	string_new(static, reply, 256);
+	int offset, fraction;
+	bool_t negative;
+	int64_t scaled;
+	char current;
+
+	string_clear(&reply);
+
+	if(!i2c_sensor_read(&reply, 0, sensor, false))
+		return(false);
+
+	for(offset = 0; (offset < string_length(&reply)) && (string_index(&reply, offset) != '['); offset++)
+		;
+
+	if(++offset >= string_length(&reply))
+		return(false);
+
+	if((negative = (string_index(&reply, offset) == '-')))
+		offset++;
+
+	for(scaled = 0, fraction = -1; offset < string_length(&reply); offset++)
+	{
+		current = string_index(&reply, offset);
+
+		if(current == '.')
+			fraction = 0;
+		else
+			if((current >= '0') && (current <= '9'))
+			{
+				scaled = (scaled * 10) + (current - '0');
+
+				if(fraction >= 0)
+					fraction++;
+			}
+			else
+				break;
+	}
+
+	if((current != ']') || (fraction <= 0))
+		return(false);
+
+	for(*value = negative ? -(double)scaled : (double)scaled; fraction > 0; fraction--)
+		*value /= 10;
+
+	*value /= scale;
+
+	return(true);
+}
+
+static void bme280_reference(int32_t adc_T, int32_t adc_P, int32_t adc_H, double *temperature, double *pressure, double *humidity)
+{
+	double var1, var2, t_fine;
+
+	var1 = (adc_T / 16384.0 - calibration.t1 / 1024.0) * calibration.t2;
+	var2 = ((adc_T / 131072.0 - calibration.t1 / 8192.0) * (adc_T / 131072.0 - calibration.t1 / 8192.0)) * calibration.t3;
+	t_fine = var1 + var2;
+
+	*temperature = t_fine / 5120.0;
+
+	var1 = (t_fine / 2.0) - 64000.0;
+	var2 = var1 * var1 * calibration.p6 / 32768.0;
+	var2 = var2 + var1 * calibration.p5 * 2.0;
+	var2 = (var2 / 4.0) + (calibration.p4 * 65536.0);
+	var1 = (calibration.p3 * var1 * var1 / 524288.0 + calibration.p2 * var1) / 524288.0;
+	var1 = (1.0 + var1 / 32768.0) * calibration.p1;
+
+	*pressure = 1048576.0 - adc_P;
+	*pressure = (*pressure - (var2 / 4096.0)) * 6250.0 / var1;
+	var1 = calibration.p9 * *pressure * *pressure / 2147483648.0;
+	var2 = *pressure * calibration.p8 / 32768.0;
+	*pressure = (*pressure + (var1 + var2 + calibration.p7) / 16.0) / 100.0;
+
+	*humidity = t_fine - 76800.0;
+	*humidity = (adc_H - (calibration.h4 * 64.0 + calibration.h5 / 16384.0 * *humidity)) *
+			(calibration.h2 / 65536.0 * (1.0 + calibration.h6 / 67108864.0 * *humidity * (1.0 + calibration.h3 / 67108864.0 * *humidity)));
+	*humidity = *humidity * (1.0 - calibration.h1 * *humidity / 524288.0);
+
+	if(*humidity > 100.0)
+		*humidity = 100.0;
+
+	if(*humidity < 0.0)
+		*humidity = 0.0;
+}
+
+static void test_bme280(void)
+{
+	int32_t adc_T, adc_P, adc_H;
+	double temperature, pressure, humidity, value;
+	double error_temperature, error_pressure, error_humidity;
+	bool_t ok;
+
+	bme280_setup();
+
+	check(i2c_sensor_init(0, i2c_sensor_bme280_temperature) == i2c_error_ok);
+	check(i2c_sensor_init(0, i2c_sensor_bme280_airpressure) == i2c_error_ok);
+	check(i2c_sensor_init(0, i2c_sensor_bme280_humidity) == i2c_error_ok);
+
+	// the datasheet example, 25.08 C and 1006.53 hPa
+
+	bme280_adc(519888, 415148, 30000);
+	check(sensor_value(i2c_sensor_bme280_temperature, bme280_scale_temperature, &value) && (fabs(value - 25.08) < 0.005));
+	check(sensor_value(i2c_sensor_bme280_airpressure, bme280_scale_airpressure, &value) && (fabs(value - 1006.53) < 0.005));
+
+	// sweep, about -40 C to 85 C, 300 to 1100 hPa, the full humidity range
+
+	error_temperature = error_pressure = error_humidity = 0;
+	ok = true;
+
+	for(adc_T = 370000; ok && (adc_T <= 680000); adc_T += 7919)
+	{
+		for(adc_P = 240000; ok && (adc_P <= 560000); adc_P += 15013)
+		{
+			for(adc_H = 15000; ok && (adc_H <= 50000); adc_H += 2011)
+			{
+				bme280_adc(adc_T, adc_P, adc_H);
+				bme280_reference(adc_T, adc_P, adc_H, &temperature, &pressure, &humidity);
+
+				ok = sensor_value(i2c_sensor_bme280_temperature, bme280_scale_temperature, &value);
+				error_temperature = fmax(error_temperature, fabs(value - temperature));
+
+				ok = ok && sensor_value(i2c_sensor_bme280_airpressure, bme280_scale_airpressure, &value);
+				error_pressure = fmax(error_pressure, fabs(value - pressure));
+
+				ok = ok && sensor_value(i2c_sensor_bme280_humidity, bme280_scale_humidity, &value);
+				error_humidity = fmax(error_humidity, fabs(value - humidity));
+			}
+		}
+	}
+
+	check(ok);
+	check(error_temperature < 0.01);
+	check(error_pressure < 0.01);
+	check(error_humidity < 0.01);
+}
+
+// digipicco temperature, 0 - 32767 is -40.5 C to 124.5 C
+
+static void test_digipicco(void)
+{
+	int raw;
+	double value, reference, error;
+	bool_t ok;
+
+	host_reset();
+	host_i2c_attach(host_i2c_digipicco, true);
+	host_digipicco_set(0, 0);
+
+	config_set_int("i2s.%u.%u.factor", 0, i2c_sensor_digipicco_temperature, digipicco_scale_temperature * 1000);
+
+	check(i2c_sensor_init(0, i2c_sensor_digipicco_temperature) == i2c_error_ok);
+
+	for(raw = 0, error = 0, ok = true; ok && (raw <= 32767); raw += 37)
+	{
+		host_digipicco_set(0, raw);
+		reference = ((raw * 165.0) / 32767.0) - 40.5;
+
+		ok = sensor_value(i2c_sensor_digipicco_temperature, digipicco_scale_temperature, &value);
+		error = fmax(error, fabs(value - reference));
+	}
+
+	check(ok);
+	check(error < 0.002);
+}
+
+void test_sensor(void)
+{
+	test_bme280();
+	test_digipicco();
+}
@@ -0,0 +1,134 @@
+#include "host.h"
+
+#include <string.h>
+#include <limits.h>
+
+int ets_vsnprintf(char *, size_t, const char *, va_list);
+
+// string_format against the libc formatter it replaced, for the subset the tree uses
+
+static void format_expected(char *dst, size_t size, const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	ets_vsnprintf(dst, size, fmt, ap);
+	va_end(ap);
+}
+
+static bool_t format_matches(const char *fmt, int value1, int value2)
+{
+	string_new(static, formatted, 128);
+	char expected[128];
+
+	format_expected(expected, sizeof(expected), fmt, value1, value2);
+
+	string_clear(&formatted);
+	string_format_data(&formatted, fmt, value1, value2);
+
+	return(string_match(&formatted, expected));
+}
+
+static bool_t format_string_matches(const char *fmt, const char *src)
+{
+	string_new(static, formatted, 128);
+	char expected[128];
+
+	format_expected(expected, sizeof(expected), fmt, src);
+
+	string_clear(&formatted);
+	string_format_data(&formatted, fmt, src);
+
+	return(string_match(&formatted, expected));
+}
+
+static void test_string_format(void)
+{
+	string_new(static, small, 8);
+
+	check(format_matches("plain text", 0, 0));
+	check(format_matches("%d %d", 0, -1));
+	check(format_matches("%d %d", INT_MAX, INT_MIN));
+	check(format_matches("%u %u", 0, UINT_MAX));
+	check(format_matches("%x %X", 0xdeadbeef, 0xabcdef));
+	check(format_matches("%04x:%02X", 0x1f, 0xa));
+	check(format_matches("[%5d] [%-5d]", 42, -42));
+	check(format_matches("[%05d] [%05d]", 42, -42));
+	check(format_matches("[%2d] [%-2u]", 12345, 12345));
+	check(format_matches("%c%c", 'o', 'k'));
+	check(format_matches("100%% %u", 7, 0));
+	check(format_matches("%d%%", -5, 0));
+
+	check(format_string_matches("%s", ""));
+	check(format_string_matches("[%s]", "string"));
+	check(format_string_matches("[%8s]", "right"));
+	check(format_string_matches("[%-8s]", "left"));
+	check(format_string_matches("[%2s]", "longer than width"));
+
+	// the output is truncated to the string size, not past it
+
+	string_format_data(&small, "%s", "0123456789");
+	check(string_length(&small) == string_size(&small));
+	check(string_match(&small, "0123456"));
+
+	string_clear(&small);
+	string_format_data(&small, "abcde%u", 123456);
+	check(string_match(&small, "abcde12"));
+}
+
+// crc32 against a bitwise reference, same polynomial, initial value and final xor (crc-32/bzip2)
+
+static uint32_t crc32_bitwise(const uint8_t *data, int length)
+{
+	uint32_t remainder = 0xffffffff;
+	int bit;
+
+	for(; length > 0; data++, length--)
+	{
+		remainder ^= (uint32_t)*data << 24;
+
+		for(bit = 8; bit > 0; bit--)
+			remainder = (remainder & (1U << 31)) ? ((remainder << 1) ^ 0x04c11db7) : (remainder << 1);
+	}
+
+	return(remainder ^ 0xffffffff);
+}
+
+static void test_string_crc32(void)
+{
+	string_new(static, data, 300);
+	uint32_t seed;
+	int ix, offset, length;
+	bool_t ok;
+
+	string_clear(&data);
+	string_cat_strptr(&data, "123456789");
+	check(string_crc32(&data, 0, 9) == 0xfc891918);
+	check(string_crc32(&data, 0, 1000) == 0xfc891918);
+	check(string_crc32(&data, -1, 9) == 0xfc891918);
+	check(string_crc32(&data, 0, 0) == 0x00000000);
+	check(string_crc32(&data, 9, 1) == 0x00000000);
+
+	// random data at every head alignment and every length, against the bitwise reference
+
+	for(ix = 0, seed = 1; ix < 256; ix++)
+	{
+		seed = (seed * 1103515245) + 12345;
+		data.buffer[ix] = (char)(seed >> 16);
+	}
+
+	data.length = 256;
+
+	for(offset = 0, ok = true; offset < 8; offset++)
+		for(length = 0; length <= (256 - offset); length++)
+			if(string_crc32(&data, offset, length) != crc32_bitwise((const uint8_t *)data.buffer + offset, length))
+				ok = false;
+
+	check(ok);
+}
+
+void test_util(void)
+{
+	test_string_format();
+	test_string_crc32();
+}
@@ -3,10 +3,12 @@
 #include "util.h"
 #include "config.h"
 
+// cooked values are fixed point, in 1/1000 units
+
 typedef struct
 {
-	double raw;
-	double cooked;
+	uint32_t raw;
+	int32_t cooked;
 } value_t;
 
 typedef struct attr_packed
@@ -50,7 +52,7 @@ irom static i2c_error_t sensor_digipicco_temp_read(int bus, const device_table_e
 		return(error);
 
 	value->raw = ((uint16_t)i2cbuffer[2] << 8) | (uint16_t)i2cbuffer[3];
-	value->cooked = ((value->raw * 165.0) / 32767.0) - 40.5;
+	value->cooked = (int32_t)(((uint64_t)value->raw * 165000) / 32767) - 40500;
 
 	return(i2c_error_ok);
 }
@@ -72,7 +74,7 @@ irom static i2c_error_t sensor_digipicco_hum_read(int bus, const device_table_en
 		return(error);
 
 	value->raw = ((uint16_t)i2cbuffer[0] << 8) | (uint16_t)i2cbuffer[1];
-	value->cooked = (value->raw * 100.0) / 32768.0;
+	value->cooked = (value->raw * 3125) / 1024;
 
 	return(i2c_error_ok);
 }
@@ -114,10 +116,10 @@ irom static i2c_error_t sensor_ds1631_read(int bus, const device_table_entry_t *
 	if(raw & 0x8000)
 	{
 		raw &= ~(uint32_t)0x8000;
-		value->cooked = (double)raw / -256;
+		value->cooked = 0 - ((raw * 1000) / 256);
 	}
 	else
-		value->cooked = (double)raw / 256;
+		value->cooked = (raw * 1000) / 256;
 
 	return(i2c_error_ok);
 }
@@ -189,10 +191,10 @@ irom static i2c_error_t sensor_lm75_read(int bus, const device_table_entry_t *en
 	if(raw & 0x8000)
 	{
 		raw &= ~0x8000;
-		value->cooked = (double)raw / -256;
+		value->cooked = 0 - ((raw * 1000) / 256);
 	}
 	else
-		value->cooked = (double)raw / 256;
+		value->cooked = (raw * 1000) / 256;
 
 	return(i2c_error_ok);
 }
@@ -288,7 +290,7 @@ irom static i2c_error_t bmp085_read(int address, value_t *rv_temperature, value_
 	if(rv_temperature)
 	{
 		rv_temperature->raw		= ut;
-		rv_temperature->cooked	= ((b5 + 8.0) / 16) / 10;
+		rv_temperature->cooked	= ((b5 + 8) * 25) / 4;
 	}
 
 	/* set cmd = 0x34 = start air pressure measurement */
@@ -333,7 +335,7 @@ irom static i2c_error_t bmp085_read(int address, value_t *rv_temperature, value_
 	if(rv_airpressure)
 	{
 		rv_airpressure->raw = up;
-		rv_airpressure->cooked = p / 100.0;
+		rv_airpressure->cooked = p * 10;
 	}
 
 	return(i2c_error_ok);
@@ -399,21 +401,21 @@ irom static i2c_error_t sensor_bmp085_read_pressure(int bus, const device_table_
 
 typedef struct
 {
-	const double ratio_top;
-	const double ch0_factor;
-	const double ch1_factor;
+	const uint16_t ratio_top;	// ch1 / ch0 * 1000
+	const uint16_t ch0_factor;	// lux per count * 100000
+	const uint16_t ch1_factor;	// lux per count * 100000
 } tsl2560_lookup_t;
 
 static const tsl2560_lookup_t tsl2560_lookup[] =
 {
-	{ 0.125, 0.03040, 0.02720 },
-	{ 0.250, 0.03250, 0.04400 },
-	{ 0.375, 0.03510, 0.05440 },
-	{ 0.500, 0.03810, 0.06240 },
-	{ 0.610, 0.02240, 0.03100 },
-	{ 0.800, 0.01280, 0.01530 },
-	{ 1.300, 0.00146, 0.00112 },
-	{ 0.000, 0.00000, 0.00000 }
+	{ 125,	3040,	2720 },
+	{ 250,	3250,	4400 },
+	{ 375,	3510,	5440 },
+	{ 500,	3810,	6240 },
+	{ 610,	2240,	3100 },
+	{ 800,	1280,	1530 },
+	{ 1300,	146,	112 },
+	{ 0,	0,		0 }
 };
 
 irom static i2c_error_t tsl2560_write(int address, int reg, int value)
@@ -532,8 +534,8 @@ irom static i2c_error_t sensor_tsl2560_read(int bus, const device_table_entry_t
 {
 	uint8_t	i2cbuffer[4];
 	i2c_error_t	error;
-	unsigned int ch0r, ch1r;
-	double ratio, ch0, ch1;
+	unsigned int ch0r, ch1r, ch0, ch1;
+	int64_t lux;
 	const tsl2560_lookup_t *tsl2560_entry;
 	int current;
 
@@ -550,11 +552,11 @@ irom static i2c_error_t sensor_tsl2560_read(int bus, const device_table_entry_t
 	ch0r = i2cbuffer[0] | (i2cbuffer[1] << 8);
 	ch1r = i2cbuffer[2] | (i2cbuffer[3] << 8);
 
-	value->raw = ((double)ch1r * 1000000) + (double)ch0r;
+	value->raw = (ch1r << 16) | ch0r;
 
 	if((ch0r == 65535) || (ch1r == 65535))
 	{
-		value->cooked = -1;
+		value->cooked = -1000;
 		return(i2c_error_ok);
 	}
 
@@ -563,38 +565,35 @@ irom static i2c_error_t sensor_tsl2560_read(int bus, const device_table_entry_t
 		// high sensitivity = 400 ms integration time, scaling factor = 1
 		// analogue amplification = 16x, scaling factor = 1
 
-		ch0 = (double)ch0r * 1.0;
-		ch1 = (double)ch1r * 1.0;
+		ch0 = ch0r;
+		ch1 = ch1r;
 	}
 	else
 	{
 		// low  sensitivity =  400 ms integration time, scaling factor = 1
 		// analogue amplification = 1x, scaling factor = 16
 
-		ch0 = (double)ch0r * 1.0 * 16.0;
-		ch1 = (double)ch1r * 1.0 * 16.0;
+		ch0 = ch0r * 16;
+		ch1 = ch1r * 16;
 	}
 
-	if((unsigned int)ch0 != 0)
-		ratio = ch1 / ch0;
-	else
-		ratio = 0;
-
 	for(current = 0;; current++)
 	{
 		tsl2560_entry = &tsl2560_lookup[current];
 
-		if(((unsigned int)tsl2560_entry->ratio_top == 0) || ((unsigned int)tsl2560_entry->ch0_factor == 0) || ((unsigned int)tsl2560_entry->ch1_factor == 0))
+		if(tsl2560_entry->ratio_top == 0)
 			break;
 
-		if(ratio <= tsl2560_entry->ratio_top)
+		if((ch1 * 1000) <= (ch0 * tsl2560_entry->ratio_top))
 			break;
 	}
 
-	value->cooked = (ch0 * tsl2560_entry->ch0_factor) - (ch1 * tsl2560_entry->ch1_factor);
+	lux = ((int64_t)ch0 * tsl2560_entry->ch0_factor) - ((int64_t)ch1 * tsl2560_entry->ch1_factor);
 
-	if(value->cooked < 0)
-		value->cooked = 0;
+	if(lux < 0)
+		lux = 0;
+
+	value->cooked = (int32_t)(lux / 100);
 
 	return(i2c_error_ok);
 }
@@ -725,7 +724,7 @@ error:
 	ch0 &= 0x7f;
 	ch1 &= 0x7f;
 
-	value->raw = (ch0 * 10000.0) + ch1;
+	value->raw = (ch0 * 10000) + ch1;
 
 	if((tsl2550_count[ch1] <= tsl2550_count[ch0]) && (tsl2550_count[ch0] > 0))
 		ratio = (tsl2550_count[ch1] * 128) / tsl2550_count[ch0];
@@ -735,7 +734,7 @@ error:
 	if(ratio > 128)
 		ratio = 128;
 
-	value->cooked = ((tsl2550_count[ch0] - tsl2550_count[ch1]) * tsl2550_ratio[ratio]) / 2560.0;
+	value->cooked = ((tsl2550_count[ch0] - tsl2550_count[ch1]) * tsl2550_ratio[ratio] * 25) / 64;
 
 	if(value->cooked < 0)
 		value->cooked = 0;
@@ -796,17 +795,17 @@ irom static i2c_error_t sensor_bh1750_read(int bus, const device_table_entry_t *
 {
 	i2c_error_t error;
 	uint8_t	i2cbuffer[2];
-	double luxpercount;
+	unsigned int luxpercount;
 
 	if((error = i2c_receive(entry->address, 2, i2cbuffer)) != i2c_error_ok)
 		return(error);
 
 	if(config_flags_get().flag.bh_high_sens)
-		luxpercount = 0.11;
+		luxpercount = 110;
 	else
-		luxpercount = 0.93;
+		luxpercount = 930;
 
-	value->raw		= (double)((i2cbuffer[0] << 8) | i2cbuffer[1]);
+	value->raw		= (i2cbuffer[0] << 8) | i2cbuffer[1];
 	value->cooked	= value->raw * luxpercount;
 
 	return(i2c_error_ok);
@@ -869,7 +868,7 @@ irom static i2c_error_t sensor_htu21_temp_read(int bus, const device_table_entry
 		return(error);
 
 	value->raw = result;
-	value->cooked = ((value->raw * 175.72) / 65536) - 46.85;
+	value->cooked = (int32_t)((value->raw * 21965) / 8192) - 46850;
 
 	return(i2c_error_ok);
 }
@@ -885,13 +884,13 @@ irom static i2c_error_t sensor_htu21_hum_read(int bus, const device_table_entry_
 		return(error);
 
 	value->raw = result;
-	value->cooked = ((value->raw * 125) / 65536) - 6;
+	value->cooked = (int32_t)((value->raw * 15625) / 8192) - 6000;
 
 	if(value->cooked < 0)
 		value->cooked = 0;
 
-	if(value->cooked > 100)
-		value->cooked = 100;
+	if(value->cooked > 100000)
+		value->cooked = 100000;
 
 	return(i2c_error_ok);
 }
@@ -999,10 +998,10 @@ irom static i2c_error_t sensor_am2321_read(int address, value_t *value, bool_t r
 	if((error = sensor_am2321_read_registers(address, 0x00, 0x04, values)) == i2c_error_ok)
 	{
 		sensor_am2321_cached_humidity.raw = (values[0] << 8) | values[1];
-		sensor_am2321_cached_humidity.cooked = sensor_am2321_cached_humidity.raw / 10.0;
+		sensor_am2321_cached_humidity.cooked = sensor_am2321_cached_humidity.raw * 100;
 
 		sensor_am2321_cached_temperature.raw = (values[2] << 8) | values[3];
-		sensor_am2321_cached_temperature.cooked = sensor_am2321_cached_temperature.raw / 10.0;
+		sensor_am2321_cached_temperature.cooked = sensor_am2321_cached_temperature.raw * 100;
 	}
 
 	if(request_humidity)
@@ -1094,7 +1093,7 @@ irom static i2c_error_t sensor_veml6070_read(int bus, const device_table_entry_t
 		return(error);
 
 	value->raw = rv;
-	value->cooked = rv * 10.0 / 2000.0; // FIXME
+	value->cooked = rv * 5; // FIXME
 
 	return(i2c_error_ok);
 }
@@ -1468,8 +1467,8 @@ irom static i2c_error_t sensor_si114x_visible_light_read(int bus, const device_t
 	if((error = si114x_read_register(si114x_als_vis_data_high, &high)) != i2c_error_ok)
 		return(error);
 
-	value->raw = value->cooked = (high << 8) | low;
-	value->cooked /= 0.282; // lx per ADC count for sunlight
+	value->raw = (high << 8) | low;
+	value->cooked = (value->raw * 35461) / 10; // 0.282 lx per ADC count for sunlight
 
 	return(i2c_error_ok);
 }
@@ -1493,8 +1492,8 @@ irom static i2c_error_t sensor_si114x_infrared_read(int bus, const device_table_
 	if((error = si114x_read_register(si114x_als_ir_data_high, &high)) != i2c_error_ok)
 		return(error);
 
-	value->raw = value->cooked = (high << 8) | low;
-	value->cooked /= 2.44; // lx per ADC count for sunlight
+	value->raw = (high << 8) | low;
+	value->cooked = (value->raw * 40984) / 100; // 2.44 lx per ADC count for sunlight
 
 	return(i2c_error_ok);
 }
@@ -1518,8 +1517,8 @@ irom static i2c_error_t sensor_si114x_ultraviolet_read(int bus, const device_tab
 	if((error = si114x_read_register(si114x_aux_data_high, &high)) != i2c_error_ok)
 		return(error);
 
-	value->raw = value->cooked = (high << 8) | low;
-	value->cooked *= 0.01;
+	value->raw = (high << 8) | low;
+	value->cooked = value->raw * 10;
 
 	return(i2c_error_ok);
 }
@@ -1576,10 +1575,10 @@ irom static i2c_error_t bme280_read(int address, value_t *rv_temperature, value_
 {
 	i2c_error_t		error;
 	uint8_t 		i2c_buffer[8];
-	int32_t			t_fine;
-	uint32_t		adc_T, adc_P, adc_H;
-	double			var1, var2;
-	double			temperature, pressure, humidity;
+	int32_t			t_fine, adc_T, adc_P, adc_H;
+	int32_t			var1, var2;
+	int32_t			temperature, humidity;
+	int64_t			p_var1, p_var2, pressure;
 
 	// retrieve all ADC values in one go to make use of the register shadowing feature
 
@@ -1593,58 +1592,64 @@ irom static i2c_error_t bme280_read(int address, value_t *rv_temperature, value_
 	adc_T	= ((i2c_buffer[3] << 16) |	(i2c_buffer[4] << 8) | (i2c_buffer[5] << 0)) >> 4;
 	adc_H	= (							(i2c_buffer[6] << 8) | (i2c_buffer[7] << 0)) >> 0;
 
-	var1 = (adc_T / 16384.0 - bme280.dig_T1 / 1024.0) * bme280.dig_T2;
-	var2 = ((adc_T / 131072.0 - bme280.dig_T1 / 8192.0) * (adc_T / 131072.0 - bme280.dig_T1 / 8192.0)) * bme280.dig_T3;
+	// integer compensation from the Bosch datasheet,
+	// temperature in 0.01 C, pressure in 1/256 Pa, humidity in 1/1024 %
 
-	t_fine = (int32_t)(var1 + var2);
+	var1 = ((((adc_T >> 3) - ((int32_t)bme280.dig_T1 << 1))) * ((int32_t)bme280.dig_T2)) >> 11;
+	var2 = (((((adc_T >> 4) - ((int32_t)bme280.dig_T1)) * ((adc_T >> 4) - ((int32_t)bme280.dig_T1))) >> 12) * ((int32_t)bme280.dig_T3)) >> 14;
 
-	temperature = (var1 + var2) / 5120.0;
+	t_fine = var1 + var2;
 
-	var1 = (t_fine / 2.0) - 64000.0;
-	var2 = var1 * var1 * bme280.dig_P6 / 32768.0;
-	var2 = var2 + var1 * bme280.dig_P5 * 2.0;
-	var2 = (var2 / 4.0) + (bme280.dig_P4 * 65536.0);
-	var1 = (bme280.dig_P3 * var1 * var1 / 524288.0 + bme280.dig_P2 * var1) / 524288.0;
-	var1 = (1.0 + var1 / 32768.0) * bme280.dig_P1;
+	temperature = ((t_fine * 5) + 128) >> 8;
 
-	if(var1 < 0.0001)
+	p_var1 = ((int64_t)t_fine) - 128000;
+	p_var2 = p_var1 * p_var1 * (int64_t)bme280.dig_P6;
+	p_var2 = p_var2 + ((p_var1 * (int64_t)bme280.dig_P5) << 17);
+	p_var2 = p_var2 + (((int64_t)bme280.dig_P4) << 35);
+	p_var1 = ((p_var1 * p_var1 * (int64_t)bme280.dig_P3) >> 8) + ((p_var1 * (int64_t)bme280.dig_P2) << 12);
+	p_var1 = ((((int64_t)1) << 47) + p_var1) * ((int64_t)bme280.dig_P1) >> 33;
+
+	if(p_var1 == 0)
 		pressure = 0;
 	else
 	{
-		pressure = 1048576.0 - adc_P;
-		pressure = (pressure - (var2 / 4096.0)) * 6250.0 / var1;
-		var1 = bme280.dig_P9 * pressure * pressure / 2147483648.0;
-		var2 = pressure * bme280.dig_P8 / 32768.0;
-		pressure = pressure + (var1 + var2 + bme280.dig_P7) / 16.0;
-		pressure /= 100.0;
+		pressure = 1048576 - adc_P;
+		pressure = (((pressure << 31) - p_var2) * 3125) / p_var1;
+		p_var1 = (((int64_t)bme280.dig_P9) * (pressure >> 13) * (pressure >> 13)) >> 25;
+		p_var2 = (((int64_t)bme280.dig_P8) * pressure) >> 19;
+		pressure = ((pressure + p_var1 + p_var2) >> 8) + (((int64_t)bme280.dig_P7) << 4);
 	}
 
-	humidity = (t_fine - 76800.0);
-	humidity = (adc_H - (bme280.dig_H4 * 64.0 + bme280.dig_H5 / 16384.0 * humidity)) * (bme280.dig_H2 / 65536.0 * (1.0 + bme280.dig_H6 / 67108864.0 * humidity * (1.0 + bme280.dig_H3 / 67108864.0 * humidity)));
-	humidity = humidity * (1.0 - bme280.dig_H1 * humidity / 524288.0);
+	humidity = t_fine - 76800;
+	humidity = ((((adc_H << 14) - (((int32_t)bme280.dig_H4) << 20) - (((int32_t)bme280.dig_H5) * humidity)) + 16384) >> 15) *
+			(((((((humidity * ((int32_t)bme280.dig_H6)) >> 10) * (((humidity * ((int32_t)bme280.dig_H3)) >> 11) + 32768)) >> 10) + 2097152) *
+			((int32_t)bme280.dig_H2) + 8192) >> 14);
+	humidity = humidity - (((((humidity >> 15) * (humidity >> 15)) >> 7) * ((int32_t)bme280.dig_H1)) >> 4);
+
+	if(humidity < 0)
+		humidity = 0;
 
-	if (humidity > 100.0)
-		humidity = 100.0;
+	if(humidity > 419430400)
+		humidity = 419430400;
 
-	if (humidity < 0.0)
-		humidity = 0.0;
+	humidity = humidity >> 12;
 
 	if(rv_temperature)
 	{
 		rv_temperature->raw = adc_T;
-		rv_temperature->cooked = temperature;
+		rv_temperature->cooked = temperature * 10;
 	}
 
 	if(rv_pressure)
 	{
 		rv_pressure->raw = adc_P;
-		rv_pressure->cooked = pressure;
+		rv_pressure->cooked = (int32_t)((pressure * 10) / 256);
 	}
 
 	if(rv_humidity)
 	{
 		rv_humidity->raw = adc_H;
-		rv_humidity->cooked = humidity;
+		rv_humidity->cooked = (humidity * 1000) / 1024;
 	}
 
 	return(i2c_error_ok);
@@ -1994,6 +1999,24 @@ irom void i2c_sensor_init_all(void)
 				i2c_sensor_init(bus, current);
 }
 
+irom static void i2c_sensor_format_value(string_t *dst, int32_t value, int precision)
+{
+	int32_t divisor;
+	int digit;
+
+	// value is in 1/1000 units, round to the requested number of decimals
+
+	for(divisor = 1, digit = precision; digit < 3; digit++)
+		divisor *= 10;
+
+	if(value < 0)
+		value = (value - (divisor / 2)) / divisor;
+	else
+		value = (value + (divisor / 2)) / divisor;
+
+	string_fixed(dst, value, precision);
+}
+
 irom bool_t i2c_sensor_read(string_t *dst, int bus, i2c_sensor_t sensor, bool_t verbose)
 {
 	const device_table_entry_t *entry;
@@ -2001,7 +2024,7 @@ irom bool_t i2c_sensor_read(string_t *dst, int bus, i2c_sensor_t sensor, bool_t
 	value_t value;
 	int current;
 	int int_factor, int_offset;
-	double extracooked;
+	int32_t extracooked;
 
 	for(current = 0; current < i2c_sensor_size; current++)
 	{
@@ -2037,10 +2060,10 @@ irom bool_t i2c_sensor_read(string_t *dst, int bus, i2c_sensor_t sensor, bool_t
 		if(!config_get_int("i2s.%u.%u.offset", bus, sensor, &int_offset))
 			int_offset = 0;
 
-		extracooked = (value.cooked * int_factor / 1000.0) + (int_offset / 1000.0);
+		extracooked = (int32_t)(((int64_t)value.cooked * int_factor) / 1000) + int_offset;
 
 		string_cat(dst, "[");
-		string_double(dst, extracooked, entry->precision, 1e10);
+		i2c_sensor_format_value(dst, extracooked, entry->precision);
 		string_cat(dst, "]");
 
 		string_format(dst, " %s", entry->unity);
@@ -2048,9 +2071,9 @@ irom bool_t i2c_sensor_read(string_t *dst, int bus, i2c_sensor_t sensor, bool_t
 		if(verbose)
 		{
 			string_cat(dst, " (uncalibrated: ");
-			string_double(dst, value.cooked, entry->precision, 1e10);
+			i2c_sensor_format_value(dst, value.cooked, entry->precision);
 			string_cat(dst, ", raw: ");
-			string_double(dst, value.raw, 0, 1e10);
+			string_format(dst, "%u", value.raw);
 			string_cat(dst, ")");
 		}
 	}
@@ -2074,9 +2097,9 @@ irom bool_t i2c_sensor_read(string_t *dst, int bus, i2c_sensor_t sensor, bool_t
 			int_offset = 0;
 
 		string_cat(dst, ", calibration: factor=");
-		string_double(dst, int_factor / 1000.0, 4, 1e10);
+		string_fixed(dst, int_factor * 10, 4);
 		string_cat(dst, ", offset=");
-		string_double(dst, int_offset / 1000.0, 4, 1e10);
+		string_fixed(dst, int_offset * 10, 4);
 	}
 
 	i2c_select_bus(0);
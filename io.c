@@ -2,9 +2,14 @@
 #include "io_aux.h"
 #include "io_mcp.h"
 #include "io_pcf.h"
+#include "io_sim.h"
+#include "io_debounce.h"
 #include "io.h"
 #include "i2c.h"
 #include "config.h"
+#include "stats.h"
+
+#include <user_interface.h>
 
 io_config_pin_entry_t io_config[io_id_size][max_pins_per_io];
 
@@ -24,6 +29,9 @@ io_info_t io_info =
 			.i2c = 1,
 			.uart = 1,
 			.pullup = 1,
+			.edge_timing = 1,
+			.deferred = 0,
+			.sigma_delta = 1,
 		},
 		"Internal GPIO",
 		io_gpio_init,
@@ -32,6 +40,7 @@ io_info_t io_info =
 		io_gpio_get_pin_info,
 		io_gpio_read_pin,
 		io_gpio_write_pin,
+		(void *)0,
 	},
 	{
 		/* io_id_aux = 1 */
@@ -47,6 +56,9 @@ io_info_t io_info =
 			.i2c = 0,
 			.uart = 0,
 			.pullup = 0,
+			.edge_timing = 0,
+			.deferred = 0,
+			.sigma_delta = 0,
 		},
 		"Auxilliary GPIO (RTC+ADC)",
 		io_aux_init,
@@ -55,6 +67,7 @@ io_info_t io_info =
 		io_aux_get_pin_info,
 		io_aux_read_pin,
 		io_aux_write_pin,
+		(void *)0,
 	},
 	{
 		/* io_id_mcp_20 = 2 */
@@ -70,6 +83,9 @@ io_info_t io_info =
 			.i2c = 0,
 			.uart = 0,
 			.pullup = 1,
+			.edge_timing = 0,
+			.deferred = 1,
+			.sigma_delta = 0,
 		},
 		"MCP23017 I2C I/O expander",
 		io_mcp_init,
@@ -78,6 +94,7 @@ io_info_t io_info =
 		io_mcp_get_pin_info,
 		io_mcp_read_pin,
 		io_mcp_write_pin,
+		io_mcp_flush,
 	},
 	{
 		/* io_id_pcf_3a = 3 */
@@ -86,21 +103,52 @@ io_info_t io_info =
 		8,
 		{
 			.input_digital = 1,
-			.counter = 0,
+			.counter = 1,
 			.output_digital = 1,
 			.input_analog = 0,
 			.output_analog = 0,
 			.i2c = 0,
 			.uart = 0,
 			.pullup = 0,
+			.edge_timing = 0,
+			.deferred = 1,
+			.sigma_delta = 0,
 		},
 		"PCF8574A I2C I/O expander",
 		io_pcf_init,
-		0,
+		io_pcf_periodic,
 		io_pcf_init_pin_mode,
 		0,
 		io_pcf_read_pin,
 		io_pcf_write_pin,
+		io_pcf_flush,
+	},
+	{
+		/* io_id_sim = 4 */
+		0x00,
+		0,
+		io_sim_pins,
+		{
+			.input_digital = 1,
+			.counter = 1,
+			.output_digital = 1,
+			.input_analog = 0,
+			.output_analog = 1,
+			.i2c = 0,
+			.uart = 0,
+			.pullup = 0,
+			.edge_timing = 0,
+			.deferred = 0,
+			.sigma_delta = 0,
+		},
+		"Simulated I/O",
+		io_sim_init,
+		io_sim_periodic,
+		io_sim_init_pin_mode,
+		io_sim_get_pin_info,
+		io_sim_read_pin,
+		io_sim_write_pin,
+		(void *)0,
 	}
 };
 
@@ -125,6 +173,9 @@ static io_mode_trait_t io_mode_traits[io_pin_size] =
 	{ io_pin_uart,				"uart"		},
 	{ io_pin_lcd,				"lcd"		},
 	{ io_pin_trigger,			"trigger"	},
+	{ io_pin_frequency,			"frequency"	},
+	{ io_pin_pulse_width,		"pulse"		},
+	{ io_pin_encoder,			"encoder"	},
 };
 
 irom static io_pin_mode_t io_mode_from_string(const string_t *src)
@@ -178,6 +229,10 @@ static io_ll_mode_trait_t io_ll_mode_traits[io_pin_ll_size] =
 	{ io_pin_ll_output_analog,		"a-output"	},
 	{ io_pin_ll_i2c,				"i2c"		},
 	{ io_pin_ll_uart,				"uart"		},
+	{ io_pin_ll_frequency,			"frequency"	},
+	{ io_pin_ll_pulse_width,		"pulse"		},
+	{ io_pin_ll_encoder,			"encoder"	},
+	{ io_pin_ll_output_sigma_delta,	"sigma-delta"	},
 };
 
 irom void io_string_from_ll_mode(string_t *name, io_pin_ll_mode_t mode)
@@ -185,7 +240,7 @@ irom void io_string_from_ll_mode(string_t *name, io_pin_ll_mode_t mode)
 	int ix;
 	const io_ll_mode_trait_t *entry;
 
-	for(ix = 0; ix < io_pin_size; ix++)
+	for(ix = 0; ix < io_pin_ll_size; ix++)
 	{
 		entry = &io_ll_mode_traits[ix];
 
@@ -332,6 +387,10 @@ irom static bool pin_flag_from_string(const string_t *flag, io_config_pin_entry_
 		pin_config->flags.pullup = value;
 	else if(string_match(flag, "reset-on-read"))
 		pin_config->flags.reset_on_read = value;
+	else if(string_match(flag, "rising"))
+		pin_config->flags.rising = value;
+	else if(string_match(flag, "falling"))
+		pin_config->flags.falling = value;
 	else
 		return(false);
 
@@ -366,10 +425,226 @@ irom static void pin_string_from_flags(string_t *flags, const io_config_pin_entr
 		string_cat(flags, " reset-on-read");
 	}
 
+	if(pin_config->flags.rising)
+	{
+		none = false;
+		string_cat(flags, " rising");
+	}
+
+	if(pin_config->flags.falling)
+	{
+		none = false;
+		string_cat(flags, " falling");
+	}
+
 	if(none)
 		string_cat(flags, " <none>");
 }
 
+// timer queue, pending timer pin edges sorted by deadline, the first one is armed on the us timer
+
+enum
+{
+	io_timer_queue_size = 16,
+	io_timer_max_delay = 0x0fffffff,
+};
+
+typedef struct
+{
+	uint64_t	deadline;
+	uint8_t		io;
+	uint8_t		pin;
+} io_timer_entry_t;
+
+static ETSTimer io_timer;
+static unsigned int io_timer_queue_length;
+static io_timer_entry_t io_timer_queue[io_timer_queue_size];
+
+iram static uint64_t io_timer_now(void)
+{
+	static uint32_t last, wraps;
+	uint32_t now;
+
+	// system_get_time wraps after ~71 minutes, extend it to 64 bits,
+	// this is called at least every 10 ms from io_periodic_fast
+
+	now = system_get_time();
+
+	if(now < last)
+		wraps++;
+
+	last = now;
+
+	return(((uint64_t)wraps << 32) | now);
+}
+
+irom static void io_timer_arm(void)
+{
+	uint64_t now, delay;
+
+	ets_timer_disarm(&io_timer);
+
+	if(io_timer_queue_length == 0)
+		return;
+
+	now = io_timer_now();
+
+	if(io_timer_queue[0].deadline > now)
+		delay = io_timer_queue[0].deadline - now;
+	else
+		delay = 1;
+
+	if(delay > io_timer_max_delay)
+		delay = io_timer_max_delay;
+
+	ets_timer_arm_new(&io_timer, (uint32_t)delay, false, 0);
+}
+
+irom static int io_timer_remove(int io, int pin)
+{
+	unsigned int ix, entry;
+
+	for(entry = 0; entry < io_timer_queue_length; entry++)
+	{
+		if((io_timer_queue[entry].io == io) && (io_timer_queue[entry].pin == pin))
+		{
+			io_timer_queue_length--;
+
+			for(ix = entry; ix < io_timer_queue_length; ix++)
+				io_timer_queue[ix] = io_timer_queue[ix + 1];
+
+			return(entry);
+		}
+	}
+
+	return(-1);
+}
+
+irom static void io_timer_cancel(int io, int pin)
+{
+	if(io_timer_remove(io, pin) == 0)
+		io_timer_arm();
+}
+
+irom static bool_t io_timer_schedule(int io, int pin, uint64_t deadline)
+{
+	unsigned int ix;
+
+	io_timer_remove(io, pin);
+
+	if(io_timer_queue_length >= io_timer_queue_size)
+	{
+		io_timer_arm();
+		return(false);
+	}
+
+	for(ix = io_timer_queue_length; (ix > 0) && (io_timer_queue[ix - 1].deadline > deadline); ix--)
+		io_timer_queue[ix] = io_timer_queue[ix - 1];
+
+	io_timer_queue[ix].deadline = deadline;
+	io_timer_queue[ix].io = io;
+	io_timer_queue[ix].pin = pin;
+	io_timer_queue_length++;
+
+	io_timer_arm();
+
+	return(true);
+}
+
+// timer periods are in ms, or in us when configured as "<n>us"
+
+irom static unsigned int io_timer_unit(const io_config_pin_entry_t *pin_config)
+{
+	return(pin_config->flags.timer_us ? 1 : 1000);
+}
+
+irom static uint64_t io_timer_period(const io_config_pin_entry_t *pin_config)
+{
+	return((uint64_t)pin_config->speed * io_timer_unit(pin_config));
+}
+
+irom static unsigned int io_timer_remaining(int io, int pin)
+{
+	unsigned int ix;
+	uint64_t now;
+
+	now = io_timer_now();
+
+	for(ix = 0; ix < io_timer_queue_length; ix++)
+		if((io_timer_queue[ix].io == io) && (io_timer_queue[ix].pin == pin))
+			return((io_timer_queue[ix].deadline > now) ?
+					(io_timer_queue[ix].deadline - now) / io_timer_unit(&io_config[io][pin]) : 0);
+
+	return(0);
+}
+
+irom static void io_timer_expire(int io, int pin, uint64_t deadline)
+{
+	const io_info_entry_t *info = &io_info[io];
+	io_data_pin_entry_t *pin_data = &io_data[io].pin[pin];
+	io_config_pin_entry_t *pin_config = &io_config[io][pin];
+	uint64_t period, now;
+
+	if(pin_config->mode != io_pin_timer)
+		return;
+
+	switch(pin_data->direction)
+	{
+		case(io_dir_none):
+		{
+			return;
+		}
+
+		case(io_dir_up):
+		{
+			info->write_pin_fn((string_t *)0, info, pin_data, pin_config, pin, 1);
+			pin_data->direction = io_dir_down;
+			break;
+		}
+
+		case(io_dir_down):
+		{
+			info->write_pin_fn((string_t *)0, info, pin_data, pin_config, pin, 0);
+			pin_data->direction = io_dir_up;
+			break;
+		}
+	}
+
+	if(!pin_config->flags.repeat)
+	{
+		pin_data->direction = io_dir_none;
+		return;
+	}
+
+	// schedule from the previous deadline instead of from now, so repeating pulses don't drift,
+	// but don't try to catch up after a long stall
+
+	period = io_timer_period(pin_config);
+	deadline += period;
+	now = io_timer_now();
+
+	if(deadline <= now)
+		deadline = now + period;
+
+	io_timer_schedule(io, pin, deadline);
+}
+
+iram static void io_timer_callback(void *arg)
+{
+	io_timer_entry_t entry;
+
+	(void)arg;
+
+	while((io_timer_queue_length > 0) && (io_timer_queue[0].deadline <= io_timer_now()))
+	{
+		entry = io_timer_queue[0];
+		io_timer_remove(entry.io, entry.pin);
+		io_timer_expire(entry.io, entry.pin, entry.deadline);
+	}
+
+	io_timer_arm();
+}
+
 irom static io_error_t io_read_pin_x(string_t *errormsg, const io_info_entry_t *info, io_data_pin_entry_t *pin_data, const io_config_pin_entry_t *pin_config, int pin, int *value)
 {
 	io_error_t error;
@@ -395,6 +670,9 @@ irom static io_error_t io_read_pin_x(string_t *errormsg, const io_info_entry_t *
 		case(io_pin_uart):
 		case(io_pin_lcd):
 		case(io_pin_trigger):
+		case(io_pin_frequency):
+		case(io_pin_pulse_width):
+		case(io_pin_encoder):
 		{
 			if((error = info->read_pin_fn(errormsg, info, pin_data, pin_config, pin, value)) != io_ok)
 				return(error);
@@ -419,6 +697,8 @@ irom static io_error_t io_write_pin_x(string_t *errormsg, const io_info_entry_t
 		case(io_pin_uart):
 		case(io_pin_error):
 		case(io_pin_trigger):
+		case(io_pin_frequency):
+		case(io_pin_pulse_width):
 		{
 			if(errormsg)
 				string_cat(errormsg, "cannot write to this pin");
@@ -431,6 +711,7 @@ irom static io_error_t io_write_pin_x(string_t *errormsg, const io_info_entry_t
 		case(io_pin_lcd):
 		case(io_pin_timer):
 		case(io_pin_output_analog):
+		case(io_pin_encoder):
 		{
 			if((error = info->write_pin_fn(errormsg, info, pin_data, pin_config, pin, value)) != io_ok)
 				return(error);
@@ -455,6 +736,9 @@ irom static io_error_t io_trigger_pin_x(string_t *errormsg, const io_info_entry_
 		case(io_pin_i2c):
 		case(io_pin_uart):
 		case(io_pin_error):
+		case(io_pin_frequency):
+		case(io_pin_pulse_width):
+		case(io_pin_encoder):
 		{
 			if(errormsg)
 				string_cat(errormsg, "cannot trigger this pin");
@@ -543,12 +827,13 @@ irom static io_error_t io_trigger_pin_x(string_t *errormsg, const io_info_entry_
 			{
 				case(io_trigger_off):
 				{
+					io_timer_cancel(info - io_info, pin);
+
 					value = pin_config->direction == io_dir_up ? 1 : 0;
 
 					if((error = info->write_pin_fn(errormsg, info, pin_data, pin_config, pin, value)) != io_ok)
 						return(error);
 
-					pin_data->speed = 0;
 					pin_data->direction = io_dir_none;
 
 					break;
@@ -561,9 +846,18 @@ irom static io_error_t io_trigger_pin_x(string_t *errormsg, const io_info_entry_
 					if((error = info->write_pin_fn(errormsg, info, pin_data, pin_config, pin, value)) != io_ok)
 						return(error);
 
-					pin_data->speed = pin_config->speed;
 					pin_data->direction = pin_config->direction;
 
+					if(!io_timer_schedule(info - io_info, pin, io_timer_now() + io_timer_period(pin_config)))
+					{
+						pin_data->direction = io_dir_none;
+
+						if(errormsg)
+							string_cat(errormsg, "timer queue full");
+
+						return(io_error);
+					}
+
 					break;
 				}
 
@@ -781,6 +1075,126 @@ irom io_error_t io_trigger_pin(string_t *error, int io, int pin, io_trigger_t tr
 	return(io_trigger_pin_x(error, info, pin_data, pin_config, pin, trigger_type));
 }
 
+// write out the output shadow registers of the expanders, one transaction per port
+
+irom io_error_t io_flush(string_t *error)
+{
+	const io_info_entry_t *info;
+	io_error_t rv;
+	int io;
+
+	rv = io_ok;
+
+	for(io = 0; io < io_id_size; io++)
+	{
+		info = &io_info[io];
+
+		if(io_data[io].detected && info->flush_fn && (info->flush_fn(error, info) != io_ok))
+			rv = io_error;
+	}
+
+	return(rv);
+}
+
+irom static bool_t io_config_pin_valid(const io_info_entry_t *info, const io_config_pin_entry_t *pin_config, int pin)
+{
+	bool_t valid;
+
+	if((pin_config->mode >= io_pin_size) || (pin_config->llmode >= io_pin_ll_size))
+		return(false);
+
+	switch(pin_config->mode)
+	{
+		case(io_pin_trigger): valid = info->caps.counter; break;
+		case(io_pin_frequency): valid = info->caps.edge_timing; break;
+		case(io_pin_pulse_width): valid = info->caps.edge_timing; break;
+		case(io_pin_encoder): valid = info->caps.edge_timing; break;
+		case(io_pin_timer): valid = info->caps.output_digital; break;
+		case(io_pin_output_analog): valid = info->caps.output_analog; break;
+		case(io_pin_i2c): valid = info->caps.i2c; break;
+		default: valid = true; break;
+	}
+
+	if(!valid)
+		return(false);
+
+	switch(pin_config->llmode)
+	{
+		case(io_pin_ll_input_digital): valid = info->caps.input_digital; break;
+		case(io_pin_ll_counter): valid = info->caps.counter; break;
+		case(io_pin_ll_output_digital): valid = info->caps.output_digital; break;
+		case(io_pin_ll_input_analog): valid = info->caps.input_analog; break;
+		case(io_pin_ll_output_analog): valid = info->caps.output_analog; break;
+		case(io_pin_ll_i2c): valid = info->caps.i2c; break;
+		case(io_pin_ll_uart): valid = info->caps.uart; break;
+		case(io_pin_ll_frequency): valid = info->caps.edge_timing; break;
+		case(io_pin_ll_pulse_width): valid = info->caps.edge_timing; break;
+		case(io_pin_ll_encoder): valid = info->caps.edge_timing; break;
+		case(io_pin_ll_output_sigma_delta): valid = info->caps.sigma_delta; break;
+		default: valid = true; break;
+	}
+
+	if(!valid)
+		return(false);
+
+	if((pin_config->mode == io_pin_encoder) &&
+			((pin_config->shared.encoder.partner < 0) || (pin_config->shared.encoder.partner >= info->pins) ||
+			(pin_config->shared.encoder.partner == pin) || (pin_config->shared.encoder.secondary > 1)))
+		return(false);
+
+	return(true);
+}
+
+// both pins of an encoder pair must point at each other and exactly one of them is the secondary,
+// otherwise the pair is dropped as a whole
+
+irom static void io_config_encoder_pairs_valid(const io_info_entry_t *info, int io)
+{
+	io_config_pin_entry_t *pin_config, *partner_config;
+	int pin;
+
+	for(pin = 0; pin < info->pins; pin++)
+	{
+		pin_config = &io_config[io][pin];
+
+		if(pin_config->mode != io_pin_encoder)
+			continue;
+
+		if((pin_config->shared.encoder.partner < 0) || (pin_config->shared.encoder.partner >= info->pins))
+		{
+			pin_config->mode = io_pin_disabled;
+			pin_config->llmode = io_pin_ll_disabled;
+			continue;
+		}
+
+		partner_config = &io_config[io][pin_config->shared.encoder.partner];
+
+		if((partner_config->mode == io_pin_encoder) &&
+				(partner_config->shared.encoder.partner == pin) &&
+				(partner_config->shared.encoder.secondary != pin_config->shared.encoder.secondary))
+			continue;
+
+		if((partner_config->mode == io_pin_encoder) && (partner_config->shared.encoder.partner == pin))
+		{
+			partner_config->mode = io_pin_disabled;
+			partner_config->llmode = io_pin_ll_disabled;
+		}
+
+		pin_config->mode = io_pin_disabled;
+		pin_config->llmode = io_pin_ll_disabled;
+	}
+}
+
+irom static void io_config_pin_store(int io, int pin, const io_config_pin_entry_t *pin_config)
+{
+	config_delete("io.%u.%u.", io, pin, true);
+
+	if(pin_config->mode == io_pin_disabled)
+		config_delete("io.%u.%u", io, pin, false);
+	else
+		config_set_blob("io.%u.%u", io, pin, pin_config, sizeof(*pin_config));
+}
+
 irom void io_init(void)
 {
 	const io_info_entry_t *info;
@@ -792,6 +1206,10 @@ irom void io_init(void)
 	int i2c_sda = -1;
 	int i2c_scl = -1;
 
+	ets_timer_disarm(&io_timer);
+	ets_timer_setfn(&io_timer, io_timer_callback, (void *)0);
+	io_timer_queue_length = 0;
+
 	for(io = 0; io < io_id_size; io++)
 	{
 		info = &io_info[io];
@@ -805,6 +1223,19 @@ irom void io_init(void)
 
 			pin_config = &io_config[io][pin];
 
+			if(config_get_blob("io.%u.%u", io, pin, pin_config, sizeof(*pin_config)))
+			{
+				if(!io_config_pin_valid(info, pin_config, pin))
+				{
+					pin_config->mode = io_pin_disabled;
+					pin_config->llmode = io_pin_ll_disabled;
+				}
+
+				continue;
+			}
+
+			// old style configuration, one entry per value, it's converted on the next io-mode
+
 			if(!config_get_int("io.%u.%u.mode", io, pin, &mode))
 			{
 				pin_config->mode = io_pin_disabled;
@@ -1018,6 +1449,10 @@ irom void io_init(void)
 			}
 		}
 
+		io_config_encoder_pairs_valid(info, io);
+
+		data->detected = false;
+
 		if(info->init_fn(info) == io_ok)
 		{
 			data->detected = true;
@@ -1037,6 +1472,9 @@ irom void io_init(void)
 						case(io_pin_input_analog):
 						case(io_pin_uart):
 						case(io_pin_trigger):
+						case(io_pin_frequency):
+						case(io_pin_pulse_width):
+						case(io_pin_encoder):
 						case(io_pin_error):
 						{
 							break;
@@ -1072,124 +1510,291 @@ irom void io_init(void)
 	}
 }
 
-iram void io_periodic(void)
+// event log, ring buffer of input changes and counter increments, numbered by a sequence number
+
+enum
+{
+	io_event_log_size = 64,
+};
+
+typedef struct
+{
+	uint32_t	timestamp;
+	int32_t		value;
+	uint8_t		io;
+	uint8_t		pin;
+} io_event_t;
+
+static io_event_t io_event_log[io_event_log_size];
+static uint32_t io_event_sequence;
+
+iram void io_event_add(int io, int pin, int value, uint32_t timestamp)
+{
+	io_event_t *event;
+
+	event = &io_event_log[io_event_sequence % io_event_log_size];
+
+	event->timestamp = timestamp;
+	event->value = value;
+	event->io = io;
+	event->pin = pin;
+
+	io_event_sequence++;
+}
+
+// periodic processing is split into a fast phase, run from the 10 ms timer, that only handles
+// the internal io's, and a deferred phase, run from the background task, that handles the
+// i2c expanders and everything that may trigger other pins
+
+enum
+{
+	io_deferred_budget_us = 5000,
+};
+
+static io_flags_t io_deferred_flags;
+static bool_t io_deferred_pending;
+static int io_deferred_next;
+
+irom static void io_periodic_pins(int io, const io_info_entry_t *info, io_data_entry_t *data, bool_t deferred)
 {
-	const io_info_entry_t *info;
-	io_data_entry_t *data;
 	io_config_pin_entry_t *pin_config;
 	io_data_pin_entry_t *pin_data;
-	int io, pin;
-	int trigger_status_io, trigger_status_pin;
-	io_flags_t flags = { .counter_triggered = 0 };
-	int value;
+	int pin, value;
 
-	for(io = 0; io < io_id_size; io++)
+	for(pin = 0; pin < info->pins; pin++)
 	{
-		info = &io_info[io];
-		data = &io_data[io];
-
-		if(!data->detected)
-			continue;
+		pin_config = &io_config[io][pin];
+		pin_data = &data->pin[pin];
 
-		if(info->periodic_fn)
-			info->periodic_fn(io, info, data, &flags);
-
-		for(pin = 0; pin < info->pins; pin++)
+		switch(pin_config->mode)
 		{
-			pin_config = &io_config[io][pin];
-			pin_data = &data->pin[pin];
+			case(io_pin_disabled):
+			case(io_pin_input_digital):
+			case(io_pin_counter):
+			case(io_pin_output_digital):
+			case(io_pin_timer):
+			case(io_pin_input_analog):
+			case(io_pin_i2c):
+			case(io_pin_uart):
+			case(io_pin_lcd):
+			case(io_pin_frequency):
+			case(io_pin_pulse_width):
+			case(io_pin_encoder):
+			case(io_pin_error):
+			{
+				break;
+			}
 
-			switch(pin_config->mode)
+			case(io_pin_trigger):
 			{
-				case(io_pin_disabled):
-				case(io_pin_input_digital):
-				case(io_pin_counter):
-				case(io_pin_output_digital):
-				case(io_pin_input_analog):
-				case(io_pin_i2c):
-				case(io_pin_uart):
-				case(io_pin_lcd):
-				case(io_pin_error):
-				{
+				if(!deferred)
 					break;
-				}
 
-				case(io_pin_timer):
+				if((info->read_pin_fn((string_t *)0, info, pin_data, pin_config, pin, &value) == io_ok) && (value != 0))
 				{
-					if((pin_data->direction != io_dir_none) && (pin_data->speed >= 10) && ((pin_data->speed -= 10) <= 0))
-					{
-						switch(pin_data->direction)
-						{
-							case(io_dir_none):
-							{
-								break;
-							}
-
-							case(io_dir_up):
-							{
-								info->write_pin_fn((string_t *)0, info, pin_data, pin_config, pin, 1);
-								pin_data->direction = io_dir_down;
-								break;
-							}
-
-							case(io_dir_down):
-							{
-								info->write_pin_fn((string_t *)0, info, pin_data, pin_config, pin, 0);
-								pin_data->direction = io_dir_up;
-								break;
-							}
-						}
-
-						if(pin_config->flags.repeat)
-							pin_data->speed = pin_config->speed;
-						else
-						{
-							pin_data->speed = 0;
-							pin_data->direction = io_dir_none;
-						}
-					}
-
-					break;
+					io_trigger_pin((string_t *)0,
+							pin_config->shared.trigger.io.io,
+							pin_config->shared.trigger.io.pin,
+							pin_config->shared.trigger.trigger_mode);
+					info->write_pin_fn((string_t *)0, info, pin_data, pin_config, pin, 0);
 				}
 
-				case(io_pin_trigger):
-				{
-					if((info->read_pin_fn((string_t *)0, info, pin_data, pin_config, pin, &value) == io_ok) && (value != 0))
-					{
-						io_trigger_pin((string_t *)0,
-								pin_config->shared.trigger.io.io,
-								pin_config->shared.trigger.io.pin,
-								pin_config->shared.trigger.trigger_mode);
-						info->write_pin_fn((string_t *)0, info, pin_data, pin_config, pin, 0);
-					}
+				break;
+			}
 
+			case(io_pin_output_analog):
+			{
+				if(deferred != info->caps.deferred)
 					break;
-				}
 
-				case(io_pin_output_analog):
-				{
-					if((pin_config->shared.output_analog.upper_bound > pin_config->shared.output_analog.lower_bound) &&
-							(pin_config->speed > 0) && (pin_data->direction != io_dir_none))
-						io_trigger_pin_x((string_t *)0, info, pin_data, pin_config, pin,
-								(pin_data->direction == io_dir_up) ? io_trigger_up : io_trigger_down);
+				if((pin_config->shared.output_analog.upper_bound > pin_config->shared.output_analog.lower_bound) &&
+						(pin_config->speed > 0) && (pin_data->direction != io_dir_none))
+					io_trigger_pin_x((string_t *)0, info, pin_data, pin_config, pin,
+							(pin_data->direction == io_dir_up) ? io_trigger_up : io_trigger_down);
 
-					break;
-				}
+				break;
 			}
 		}
 	}
+}
+
+iram bool_t io_periodic_fast(void)
+{
+	const io_info_entry_t *info;
+	io_data_entry_t *data;
+	int io;
 
-	if(flags.counter_triggered &&
-			config_get_int("trigger.status.io", -1, -1, &trigger_status_io) &&
-			config_get_int("trigger.status.pin", -1, -1, &trigger_status_pin) &&
-			(trigger_status_io >= 0) && (trigger_status_pin >= 0))
+	io_timer_now(); // track wraps
+
+	for(io = 0; io < io_id_size; io++)
 	{
-		io_trigger_pin((string_t *)0, trigger_status_io, trigger_status_pin, io_trigger_on);
+		info = &io_info[io];
+		data = &io_data[io];
+
+		if(!data->detected || info->caps.deferred)
+			continue;
+
+		if(info->periodic_fn)
+			info->periodic_fn(io, info, data, &io_deferred_flags);
+
+		io_periodic_pins(io, info, data, false);
 	}
+
+	// previous deferred run hasn't finished yet, don't queue another one
+
+	if(io_deferred_pending)
+	{
+		stat_io_deferred_overrun++;
+		return(false);
+	}
+
+	io_deferred_pending = true;
+
+	return(true);
+}
+
+// returns true when the budget ran out and it needs to be called again
+
+irom bool_t io_periodic_deferred(void)
+{
+	const io_info_entry_t *info;
+	io_data_entry_t *data;
+	const config_runtime_t *runtime;
+	uint32_t start;
+	int io;
+
+	if(!io_deferred_pending)
+		return(false);
+
+	start = system_get_time();
+
+	for(; io_deferred_next < io_id_size; io_deferred_next++)
+	{
+		io = io_deferred_next;
+		info = &io_info[io];
+		data = &io_data[io];
+
+		if(!data->detected)
+			continue;
+
+		// out of time, continue with this io on the next run
+
+		if((system_get_time() - start) >= io_deferred_budget_us)
+		{
+			stat_io_deferred_budget++;
+			return(true);
+		}
+
+		if(info->caps.deferred && info->periodic_fn)
+			info->periodic_fn(io, info, data, &io_deferred_flags);
+
+		io_periodic_pins(io, info, data, true);
+
+		if(info->flush_fn)
+			info->flush_fn((string_t *)0, info);
+	}
+
+	io_deferred_next = 0;
+	io_deferred_pending = false;
+
+	if(io_deferred_flags.counter_triggered)
+	{
+		io_deferred_flags.counter_triggered = 0;
+
+		runtime = config_runtime_get();
+
+		if((runtime->trigger_status_io >= 0) && (runtime->trigger_status_pin >= 0))
+			io_trigger_pin((string_t *)0, runtime->trigger_status_io, runtime->trigger_status_pin, io_trigger_on);
+	}
+
+	return(false);
 }
 
 /* app commands */
 
+irom app_action_t application_function_io_events(const string_t *src, string_t *dst)
+{
+	const io_event_t *event;
+	uint32_t first, sequence;
+	int start;
+
+	// oldest entry still available
+
+	if(io_event_sequence > io_event_log_size)
+		first = io_event_sequence - io_event_log_size;
+	else
+		first = 0;
+
+	if((parse_int(1, src, &start, 0) != parse_ok) || ((uint32_t)start < first))
+		sequence = first;
+	else
+		sequence = start;
+
+	string_format(dst, "events: first: %u, next: %u\n", first, io_event_sequence);
+
+	// stop when the output buffer is (nearly) full, the client can continue from the last sequence number
+
+	for(; (sequence < io_event_sequence) && ((string_size(dst) - string_length(dst)) > 64); sequence++)
+	{
+		event = &io_event_log[sequence % io_event_log_size];
+		string_format(dst, "%u: io %u/%u, value: %d, time: %u\n",
+				sequence, event->io, event->pin, event->value, event->timestamp);
+	}
+
+	return(app_action_normal);
+}
+
+// pin b of an encoder pair gets the same mode as pin a, marked as secondary
+
+irom static bool_t io_encoder_attach(string_t *dst, const io_info_entry_t *info, int io, int pin, int primary)
+{
+	io_config_pin_entry_t *pin_config = &io_config[io][pin];
+	io_data_pin_entry_t *pin_data = &io_data[io].pin[pin];
+
+	io_timer_cancel(io, pin);
+	pin_data->direction = io_dir_none;
+
+	*pin_config = io_config[io][primary];
+	pin_config->shared.encoder.partner = primary;
+	pin_config->shared.encoder.secondary = 1;
+
+	if(info->init_pin_mode_fn && (info->init_pin_mode_fn(dst, info, pin_data, pin_config, pin) != io_ok))
+	{
+		pin_config->mode = io_pin_disabled;
+		pin_config->llmode = io_pin_ll_disabled;
+		io_config_pin_store(io, pin, pin_config);
+		return(false);
+	}
+
+	io_config_pin_store(io, pin, pin_config);
+
+	return(true);
+}
+
+irom static void io_encoder_release(const io_info_entry_t *info, int io, int pin, int partner)
+{
+	io_config_pin_entry_t *pin_config = &io_config[io][pin];
+
+	if((pin_config->mode != io_pin_encoder) || (pin_config->shared.encoder.partner != partner))
+		return;
+
+	pin_config->mode = io_pin_disabled;
+	pin_config->llmode = io_pin_ll_disabled;
+
+	io_config_pin_store(io, pin, pin_config);
+
+	if(info->init_pin_mode_fn)
+		info->init_pin_mode_fn((string_t *)0, info, &io_data[io].pin[pin], pin_config, pin);
+}
+
+// ios with edge timing count from the interrupt with a lockout in us, the others
+// debounce by sampling in the integrator, which has a limited number of samples
+
+irom static int io_debounce_max(const io_info_entry_t *info)
+{
+	return(info->caps.edge_timing ? 65535 : io_debounce_max_ms);
+}
+
 irom app_action_t application_function_io_mode(const string_t *src, string_t *dst)
 {
 	const io_info_entry_t	*info;
@@ -1198,7 +1803,7 @@ irom app_action_t application_function_io_mode(const string_t *src, string_t *ds
 	io_data_pin_entry_t		*pin_data;
 	io_pin_mode_t			mode;
 	io_pin_ll_mode_t		llmode;
-	int io, pin;
+	int io, pin, old_partner;
 
 	if(parse_int(1, src, &io, 0) != parse_ok)
 	{
@@ -1251,6 +1856,13 @@ irom app_action_t application_function_io_mode(const string_t *src, string_t *ds
 
 	string_clear(dst);
 
+	// an encoder pin pair is always reconfigured as a whole
+
+	if(pin_config->mode == io_pin_encoder)
+		old_partner = pin_config->shared.encoder.partner;
+	else
+		old_partner = -1;
+
 	llmode = io_pin_ll_error;
 
 	switch(mode)
@@ -1265,10 +1877,6 @@ irom app_action_t application_function_io_mode(const string_t *src, string_t *ds
 
 			llmode = io_pin_ll_input_digital;
 
-			config_delete("io.%u.%u.", io, pin, true);
-			config_set_int("io.%u.%u.mode", io, pin, mode);
-			config_set_int("io.%u.%u.llmode", io, pin, io_pin_ll_input_digital);
-
 			break;
 		}
 
@@ -1288,14 +1896,15 @@ irom app_action_t application_function_io_mode(const string_t *src, string_t *ds
 				return(app_action_error);
 			}
 
+			if((debounce < 0) || (debounce > io_debounce_max(info)))
+			{
+				string_format(dst, "counter: debounce out of range: %d, max %d ms\n", debounce, io_debounce_max(info));
+				return(app_action_error);
+			}
+
 			pin_config->speed = debounce;
 			llmode = io_pin_ll_counter;
 
-			config_delete("io.%u.%u.", io, pin, true);
-			config_set_int("io.%u.%u.mode", io, pin, mode);
-			config_set_int("io.%u.%u.llmode", io, pin, io_pin_ll_counter);
-			config_set_int("io.%u.%u.counter.debounce", io, pin, debounce);
-
 			break;
 		}
 
@@ -1346,6 +1955,12 @@ irom app_action_t application_function_io_mode(const string_t *src, string_t *ds
 
 			string_clear(dst);
 
+			if((debounce < 0) || (debounce > io_debounce_max(info)))
+			{
+				string_format(dst, "trigger: debounce out of range: %d, max %d ms\n", debounce, io_debounce_max(info));
+				return(app_action_error);
+			}
+
 			pin_config->speed = debounce;
 			pin_config->shared.trigger.io.io = trigger_io;
 			pin_config->shared.trigger.io.pin = trigger_pin;
@@ -1353,13 +1968,122 @@ irom app_action_t application_function_io_mode(const string_t *src, string_t *ds
 
 			llmode = io_pin_ll_counter;
 
-			config_delete("io.%u.%u.", io, pin, true);
-			config_set_int("io.%u.%u.mode", io, pin, mode);
-			config_set_int("io.%u.%u.llmode", io, pin, io_pin_ll_counter);
-			config_set_int("io.%u.%u.trigger.debounce", io, pin, debounce);
-			config_set_int("io.%u.%u.trigger.io", io, pin, trigger_io);
-			config_set_int("io.%u.%u.trigger.pin", io, pin, trigger_pin);
-			config_set_int("io.%u.%u.trigger.type", io, pin, trigger_type);
+			break;
+		}
+
+		case(io_pin_frequency):
+		{
+			int gate;
+
+			if(!info->caps.edge_timing)
+			{
+				string_cat(dst, "frequency mode invalid for this io\n");
+				return(app_action_error);
+			}
+
+			if(parse_int(4, src, &gate, 0) != parse_ok)
+				gate = 1000;
+
+			if((gate < 10) || (gate > 65535))
+			{
+				string_format(dst, "frequency: gate time out of range: %d\n", gate);
+				return(app_action_error);
+			}
+
+			pin_config->speed = gate;
+			llmode = io_pin_ll_frequency;
+
+			break;
+		}
+
+		case(io_pin_pulse_width):
+		{
+			int timeout;
+
+			if(!info->caps.edge_timing)
+			{
+				string_cat(dst, "pulse mode invalid for this io\n");
+				return(app_action_error);
+			}
+
+			if(parse_string(4, src, dst) != parse_ok)
+			{
+				string_copy(dst, "pulse: <level>=high|low [<timeout ms>]\n");
+				return(app_action_error);
+			}
+
+			if(string_match(dst, "high"))
+				pin_config->direction = io_dir_up;
+			else
+				if(string_match(dst, "low"))
+					pin_config->direction = io_dir_down;
+				else
+				{
+					string_copy(dst, "pulse: <level>=high|low [<timeout ms>]\n");
+					return(app_action_error);
+				}
+
+			string_clear(dst);
+
+			// without edges for this long the width reads as 0
+
+			if(parse_int(5, src, &timeout, 0) != parse_ok)
+				timeout = 1000;
+
+			if((timeout < 10) || (timeout > 65535))
+			{
+				string_format(dst, "pulse: timeout out of range: %d\n", timeout);
+				return(app_action_error);
+			}
+
+			pin_config->speed = timeout;
+			llmode = io_pin_ll_pulse_width;
+
+			break;
+		}
+
+		case(io_pin_encoder):
+		{
+			const io_config_pin_entry_t *partner_config;
+			int partner, window;
+
+			if(!info->caps.edge_timing)
+			{
+				string_cat(dst, "encoder mode invalid for this io\n");
+				return(app_action_error);
+			}
+
+			if((parse_int(4, src, &partner, 0) != parse_ok) || (partner < 0) || (partner >= info->pins) || (partner == pin))
+			{
+				string_cat(dst, "encoder: <pin b> [<velocity window ms>]\n");
+				return(app_action_error);
+			}
+
+			if(parse_int(5, src, &window, 0) != parse_ok)
+				window = 100;
+
+			if((window < 10) || (window > 65535))
+			{
+				string_format(dst, "encoder: velocity window out of range: %d\n", window);
+				return(app_action_error);
+			}
+
+			// pin b is configured along with pin a, it must be free or already be our partner
+
+			partner_config = &io_config[io][partner];
+
+			if((partner_config->mode != io_pin_disabled) &&
+					((partner_config->mode != io_pin_encoder) || (partner_config->shared.encoder.partner != pin)))
+			{
+				string_format(dst, "encoder: pin %d is in use\n", partner);
+				return(app_action_error);
+			}
+
+			pin_config->speed = window;
+			pin_config->shared.encoder.partner = partner;
+			pin_config->shared.encoder.secondary = 0;
+
+			llmode = io_pin_ll_encoder;
 
 			break;
 		}
@@ -1374,16 +2098,13 @@ irom app_action_t application_function_io_mode(const string_t *src, string_t *ds
 
 			llmode = io_pin_ll_output_digital;
 
-			config_delete("io.%u.%u.", io, pin, true);
-			config_set_int("io.%u.%u.mode", io, pin, mode);
-			config_set_int("io.%u.%u.llmode", io, pin, io_pin_ll_output_digital);
-
 			break;
 		}
 
 		case(io_pin_timer):
 		{
 			io_direction_t direction;
+			bool_t timer_us;
 			int speed;
 
 			if(!info->caps.output_digital)
@@ -1394,7 +2115,7 @@ irom app_action_t application_function_io_mode(const string_t *src, string_t *ds
 
 			if(parse_string(4, src, dst) != parse_ok)
 			{
-				string_copy(dst, "timer: <direction>:up/down <speed>:ms\n");
+				string_copy(dst, "timer: <direction>:up/down <delay>:<n>ms|<n>us\n");
 				return(app_action_error);
 			}
 
@@ -1410,45 +2131,117 @@ irom app_action_t application_function_io_mode(const string_t *src, string_t *ds
 
 			string_clear(dst);
 
-			if((parse_int(5, src, &speed, 0) != parse_ok))
+			// the delay is in ms, unless it has the suffix "us"
+
+			if(parse_string(5, src, dst) != parse_ok)
+			{
+				string_copy(dst, "timer: <direction>:up/down <delay>:<n>ms|<n>us\n");
+				return(app_action_error);
+			}
+
+			timer_us = false;
+
+			if((string_length(dst) > 2) && (string_index(dst, string_length(dst) - 1) == 's'))
+			{
+				if(string_index(dst, string_length(dst) - 2) == 'u')
+					timer_us = true;
+				else
+					if(string_index(dst, string_length(dst) - 2) != 'm')
+					{
+						string_copy(dst, "timer: <direction>:up/down <delay>:<n>ms|<n>us\n");
+						return(app_action_error);
+					}
+
+				string_setlength(dst, string_length(dst) - 2);
+			}
+
+			if(parse_int(0, dst, &speed, 10) != parse_ok)
 			{
-				string_copy(dst, "timer: <direction>:up/down <speed>:ms\n");
+				string_copy(dst, "timer: <direction>:up/down <delay>:<n>ms|<n>us\n");
 				return(app_action_error);
 			}
 
-			if(speed < 10)
+			string_clear(dst);
+
+			if(speed < 1)
 			{
-				string_cat(dst, "timer: speed too small: must be >= 10 ms\n");
+				string_format(dst, "timer: delay too small: must be >= 1 %s\n", timer_us ? "us" : "ms");
 				return(app_action_error);
 			}
 
 			pin_config->direction = direction;
 			pin_config->speed = speed;
+			pin_config->flags.timer_us = timer_us;
 
 			llmode = io_pin_ll_output_digital;
 
-			config_delete("io.%u.%u.", io, pin, true);
-			config_set_int("io.%u.%u.mode", io, pin, mode);
-			config_set_int("io.%u.%u.llmode", io, pin, io_pin_ll_output_digital);
-			config_set_int("io.%u.%u.timer.direction", io, pin, direction);
-			config_set_int("io.%u.%u.timer.delay", io, pin, speed);
-
 			break;
 		}
 
 		case(io_pin_input_analog):
 		{
+			int rate, oversample, filter_length, window, order;
+			io_adc_filter_t filter;
+
 			if(!info->caps.input_analog)
 			{
 				string_cat(dst, "analog input mode invalid for this io\n");
 				return(app_action_error);
 			}
 
-			llmode = io_pin_ll_input_analog;
+			// optional background sampling, only the builtin adc supports it
+
+			if(parse_int(4, src, &rate, 0) != parse_ok)
+				rate = 0;
+
+			if(parse_int(5, src, &oversample, 0) != parse_ok)
+				oversample = 0;
+
+			if(parse_string(6, src, dst) == parse_ok)
+			{
+				filter = io_aux_adc_filter_from_string(dst);
+				string_clear(dst);
+			}
+			else
+				filter = io_adc_filter_none;
+
+			if(parse_int(7, src, &filter_length, 0) != parse_ok)
+				filter_length = 1;
+
+			if(parse_int(8, src, &window, 0) != parse_ok)
+				window = rate;
+
+			for(order = 0; (order < 7) && ((1 << order) < filter_length); order++)
+				(void)0;
 
-			config_delete("io.%u.%u.", io, pin, true);
-			config_set_int("io.%u.%u.mode", io, pin, mode);
-			config_set_int("io.%u.%u.llmode", io, pin, io_pin_ll_input_analog);
+			if((rate != 0) && (io != io_id_aux))
+			{
+				string_cat(dst, "inputa: sampling not supported for this io\n");
+				return(app_action_error);
+			}
+
+			if((rate < 0) || (rate > io_aux_adc_max_rate) ||
+					(oversample < 0) || (oversample > io_aux_adc_max_oversample) ||
+					((rate * (1 << (oversample * 2))) > io_aux_adc_max_reads_per_second) ||
+					(filter == io_adc_filter_error) ||
+					((1 << order) != filter_length) ||
+					((filter == io_adc_filter_boxcar) && (order > io_aux_adc_max_boxcar_order)) ||
+					((rate != 0) && ((window < 1) || (window > 65535))))
+			{
+				string_cat(dst, "inputa: [<rate hz> [<oversample bits> [<filter>=none|box|exp [<filter length> [<window samples>]]]]]\n");
+				string_format(dst, "  rate <= %u, oversample <= %u, rate * 4^oversample <= %u, filter length = power of 2 <= %u\n",
+						io_aux_adc_max_rate, io_aux_adc_max_oversample, io_aux_adc_max_reads_per_second,
+						(filter == io_adc_filter_boxcar) ? 1 << io_aux_adc_max_boxcar_order : 128);
+				return(app_action_error);
+			}
+
+			pin_config->speed = rate;
+			pin_config->shared.input_analog.oversample = oversample;
+			pin_config->shared.input_analog.filter = filter;
+			pin_config->shared.input_analog.filter_order = order;
+			pin_config->shared.input_analog.window = (rate != 0) ? window : 0;
+
+			llmode = io_pin_ll_input_analog;
 
 			break;
 		}
@@ -1496,19 +2289,28 @@ irom app_action_t application_function_io_mode(const string_t *src, string_t *ds
 				return(app_action_error);
 			}
 
+			llmode = io_pin_ll_output_analog;
+
+			// optional output type, software pwm (default) or hardware sigma-delta (values 0-255)
+
+			if(parse_string(7, src, dst) == parse_ok)
+			{
+				if(string_match(dst, "sd") && info->caps.sigma_delta)
+					llmode = io_pin_ll_output_sigma_delta;
+				else
+					if(!string_match(dst, "pwm"))
+					{
+						string_copy(dst, "outputa: <lower> <upper> <speed> [<type>=pwm|sd]\n");
+						return(app_action_error);
+					}
+
+				string_clear(dst);
+			}
+
 			pin_config->shared.output_analog.lower_bound = lower_bound;
 			pin_config->shared.output_analog.upper_bound = upper_bound;
 			pin_config->speed = speed;
 
-			llmode = io_pin_ll_output_analog;
-
-			config_delete("io.%u.%u.", io, pin, true);
-			config_set_int("io.%u.%u.mode", io, pin, mode);
-			config_set_int("io.%u.%u.llmode", io, pin, io_pin_ll_output_analog);
-			config_set_int("io.%u.%u.outputa.lower", io, pin, lower_bound);
-			config_set_int("io.%u.%u.outputa.upper", io, pin, upper_bound);
-			config_set_int("io.%u.%u.outputa.speed", io, pin, speed);
-
 			break;
 		}
 
@@ -1540,11 +2342,6 @@ irom app_action_t application_function_io_mode(const string_t *src, string_t *ds
 
 			llmode = io_pin_ll_i2c;
 
-			config_delete("io.%u.%u.", io, pin, true);
-			config_set_int("io.%u.%u.mode", io, pin, mode);
-			config_set_int("io.%u.%u.llmode", io, pin, io_pin_ll_i2c);
-			config_set_int("io.%u.%u.i2c.pinmode", io, pin, pin_mode);
-
 			break;
 		}
 
@@ -1558,10 +2355,6 @@ irom app_action_t application_function_io_mode(const string_t *src, string_t *ds
 
 			llmode = io_pin_ll_uart;
 
-			config_delete("io.%u.%u.", io, pin, true);
-			config_set_int("io.%u.%u.mode", io, pin, mode);
-			config_set_int("io.%u.%u.llmode", io, pin, io_pin_ll_uart);
-
 			break;
 		}
 
@@ -1609,11 +2402,6 @@ irom app_action_t application_function_io_mode(const string_t *src, string_t *ds
 
 			pin_config->shared.lcd.pin_use = pin_mode;
 
-			config_delete("io.%u.%u.", io, pin, true);
-			config_set_int("io.%u.%u.mode", io, pin, mode);
-			config_set_int("io.%u.%u.llmode", io, pin, llmode);
-			config_set_int("io.%u.%u.lcd.pin", io, pin, pin_mode);
-
 			break;
 		}
 
@@ -1621,8 +2409,6 @@ irom app_action_t application_function_io_mode(const string_t *src, string_t *ds
 		{
 			llmode = io_pin_ll_disabled;
 
-			config_delete("io.%u.%u.", io, pin, true);
-
 			break;
 		}
 
@@ -1641,9 +2427,27 @@ irom app_action_t application_function_io_mode(const string_t *src, string_t *ds
 		return(app_action_error);
 	}
 
+	io_timer_cancel(io, pin);
+	pin_data->direction = io_dir_none;
+
+	if(old_partner >= 0)
+		io_encoder_release(info, io, old_partner, pin);
+
 	pin_config->mode = mode;
 	pin_config->llmode = llmode;
 
+	// only store an encoder pin when its partner could be attached, so the pair is never half stored
+
+	if((mode == io_pin_encoder) && !io_encoder_attach(dst, info, io, pin_config->shared.encoder.partner, pin))
+	{
+		pin_config->mode = io_pin_disabled;
+		pin_config->llmode = io_pin_ll_disabled;
+		io_config_pin_store(io, pin, pin_config);
+		return(app_action_error);
+	}
+
+	io_config_pin_store(io, pin, pin_config);
+
 	if(info->init_pin_mode_fn && (info->init_pin_mode_fn(dst, info, pin_data, pin_config, pin) != io_ok))
 	{
 		pin_config->mode = io_pin_disabled;
@@ -1660,6 +2464,7 @@ irom app_action_t application_function_io_read(const string_t *src, string_t *ds
 {
 	const io_info_entry_t *info;
 	io_config_pin_entry_t *pin_config;
+	io_aux_adc_field_t field;
 	int io, pin, value;
 
 	if(parse_int(1, src, &io, 0) != parse_ok)
@@ -1690,6 +2495,27 @@ irom app_action_t application_function_io_read(const string_t *src, string_t *ds
 
 	pin_config = &io_config[io][pin];
 
+	// sub fields of the adc sampler, e.g. io-read 1 1 rms
+
+	if(parse_string(3, src, dst) == parse_ok)
+	{
+		field = io_aux_adc_field_from_string(dst);
+		string_clear(dst);
+
+		if((io != io_id_aux) || (pin != io_aux_pin_adc) || (field == io_aux_adc_error))
+		{
+			string_cat(dst, "io-read: <io> <pin> [<field>=value|raw|min|max|mean|rms|acrms] (field only for adc)\n");
+			return(app_action_error);
+		}
+
+		if(io_aux_adc_read_field(dst, pin_config, field, &value) != io_ok)
+			return(app_action_error);
+
+		string_format(dst, "adc/%s: [%d]\n", io_aux_adc_field_name(field), value);
+
+		return(app_action_normal);
+	}
+
 	io_string_from_mode(dst, pin_config->mode);
 
 	if(pin_config->mode == io_pin_i2c)
@@ -1761,7 +2587,7 @@ irom app_action_t application_function_io_write(const string_t *src, string_t *d
 
 	string_cat(dst, ": ");
 
-	if(io_write_pin(dst, io, pin, value) != io_ok)
+	if((io_write_pin(dst, io, pin, value) != io_ok) || (io_flush(dst) != io_ok))
 	{
 		string_cat(dst, "\n");
 		return(app_action_error);
@@ -1840,7 +2666,6 @@ irom static app_action_t application_function_io_clear_set_flag(const string_t *
 	io_config_pin_entry_t *pin_config;
 	int io, pin;
 	io_pin_flag_t saved_flags;
-	io_pin_flag_to_int_t io_pin_flag_to_int;
 
 	if(parse_int(1, src, &io, 0) != parse_ok)
 	{
@@ -1894,8 +2719,7 @@ irom static app_action_t application_function_io_clear_set_flag(const string_t *
 		return(app_action_error);
 	}
 
-	io_pin_flag_to_int.io_pin_flags = pin_config->flags;
-	config_set_int("io.%u.%u.flags", io, pin, io_pin_flag_to_int.intvalue);
+	io_config_pin_store(io, pin, pin_config);
 
 	string_clear(dst);
 	string_format(dst, "flags for pin %d/%d:", io, pin);
@@ -1938,6 +2762,10 @@ typedef enum
 	ds_id_i2c_scl,
 	ds_id_uart,
 	ds_id_lcd,
+	ds_id_frequency,
+	ds_id_pulse_width,
+	ds_id_encoder_a,
+	ds_id_encoder_b,
 	ds_id_unknown,
 	ds_id_not_detected,
 	ds_id_info_1,
@@ -1974,12 +2802,16 @@ static const roflash dump_string_t dump_strings =
 		"trigger, counter: %d, debounce: %d, io: %d, pin: %d, trigger type: ",
 		"",
 		"output, state: %s",
-		"timer, config direction: %s, speed: %d ms, current direction: %s, delay: %d ms, state: %s",
+		"timer, config direction: %s, speed: %d %s, current direction: %s, delay: %d %s, state: %s",
 		"analog output, min/static: %d, max: %d, current speed: %d, direction: %s, value: %d",
 		"i2c/sda",
 		"i2c/scl",
 		"uart",
 		"lcd",
+		"frequency, gate: %d ms, frequency: %d Hz",
+		"pulse width, level: %s, timeout: %d ms, width: %d us",
+		"encoder a, pin b: %d, position: %d",
+		"encoder b, pin a: %d, velocity: %d /s",
 		"unknown",
 		"  not found\n",
 		", info: ",
@@ -2004,12 +2836,16 @@ static const roflash dump_string_t dump_strings =
 		"<td>trigger</td><td>counter: %d</td><td>debounce: %d</td><td>io: %d</td><td>pin: %d</td><td>trigger type: ",
 		"</td>",
 		"<td>output</td><td>state: %s</td>",
-		"<td>timer</td><td>config direction: %s, speed: %d ms</td><<td>current direction %s, delay: %d ms, state: %s</td>",
+		"<td>timer</td><td>config direction: %s, speed: %d %s</td><<td>current direction %s, delay: %d %s, state: %s</td>",
 		"<td>analog output</td><td>min/static: %d, max: %d, speed: %d, current direction: %s, value: %d",
 		"<td>i2c</td><td>sda</td>",
 		"<td>i2c</td><td>scl, speed: %d</td>",
 		"<td>uart</td>",
 		"<td>lcd</td>",
+		"<td>frequency</td><td>gate: %d ms</td><td>frequency: %d Hz</td>",
+		"<td>pulse width</td><td>level: %s, timeout: %d ms</td><td>width: %d us</td>",
+		"<td>encoder a</td><td>pin b: %d</td><td>position: %d</td>",
+		"<td>encoder b</td><td>pin a: %d</td><td>velocity: %d /s</td>",
 		"<td>unknown</td>",
 		"<td>not found</td>",
 		"<td>",
@@ -2146,9 +2982,9 @@ irom void io_config_dump(string_t *dst, int io_id, int pin_id, bool html)
 					if(error == io_ok)
 						string_format_ptr(dst, (*strings)[ds_id_timer],
 								pin_config->direction == io_dir_up ? "up" : (pin_config->direction == io_dir_down ? "down" : "none"),
-								pin_config->speed,
+								pin_config->speed, pin_config->flags.timer_us ? "us" : "ms",
 								pin_data->direction == io_dir_up ? "up" : (pin_data->direction == io_dir_down ? "down" : "none"),
-								pin_data->speed,
+								io_timer_remaining(io, pin), pin_config->flags.timer_us ? "us" : "ms",
 								onoff(value));
 					else
 						string_cat_ptr(dst, (*strings)[ds_id_error]);
@@ -2197,6 +3033,37 @@ irom void io_config_dump(string_t *dst, int io_id, int pin_id, bool html)
 					break;
 				}
 
+				case(io_pin_frequency):
+				{
+					if(error == io_ok)
+						string_format_ptr(dst, (*strings)[ds_id_frequency], pin_config->speed, value);
+					else
+						string_cat_ptr(dst, (*strings)[ds_id_error]);
+
+					break;
+				}
+
+				case(io_pin_pulse_width):
+				{
+					if(error == io_ok)
+						string_format_ptr(dst, (*strings)[ds_id_pulse_width], (pin_config->direction == io_dir_down) ? "low" : "high",
+								pin_config->speed, value);
+					else
+						string_cat_ptr(dst, (*strings)[ds_id_error]);
+
+					break;
+				}
+
+				case(io_pin_encoder):
+				{
+					if(error == io_ok)
+						string_format_ptr(dst, (*strings)[pin_config->shared.encoder.secondary ? ds_id_encoder_b : ds_id_encoder_a],
+								pin_config->shared.encoder.partner, value);
+					else
+						string_cat_ptr(dst, (*strings)[ds_id_error]);
+
+					break;
+				}
 
 				default:
 				{
@@ -24,6 +24,7 @@ enum
 	io_id_aux,
 	io_id_mcp_20,
 	io_id_pcf_3a,
+	io_id_sim,
 	io_id_size,
 };
 
@@ -69,6 +70,9 @@ typedef enum attr_packed
 	io_pin_uart,
 	io_pin_lcd,
 	io_pin_trigger,
+	io_pin_frequency,
+	io_pin_pulse_width,
+	io_pin_encoder,
 	io_pin_error,
 	io_pin_size = io_pin_error,
 } io_pin_mode_t;
@@ -81,6 +85,9 @@ typedef struct attr_packed
 	unsigned int repeat:1;
 	unsigned int pullup:1;
 	unsigned int reset_on_read:1;
+	unsigned int rising:1;
+	unsigned int falling:1;
+	unsigned int timer_us:1;
 } io_pin_flag_t;
 
 assert_size(io_pin_flag_t, 1);
@@ -113,6 +120,10 @@ typedef enum attr_packed
 	io_pin_ll_output_analog,
 	io_pin_ll_i2c,
 	io_pin_ll_uart,
+	io_pin_ll_frequency,
+	io_pin_ll_pulse_width,
+	io_pin_ll_encoder,
+	io_pin_ll_output_sigma_delta,
 	io_pin_ll_error,
 	io_pin_ll_size = io_pin_ll_error
 } io_pin_ll_mode_t;
@@ -139,6 +150,17 @@ typedef enum attr_packed
 
 assert_size(io_lcd_mode_t, 1);
 
+typedef enum attr_packed
+{
+	io_adc_filter_none = 0,
+	io_adc_filter_boxcar,
+	io_adc_filter_exponential,
+	io_adc_filter_error,
+	io_adc_filter_size = io_adc_filter_error
+} io_adc_filter_t;
+
+assert_size(io_adc_filter_t, 1);
+
 typedef struct
 {
 	unsigned int input_digital:1;
@@ -149,6 +171,9 @@ typedef struct
 	unsigned int i2c:1;
 	unsigned int uart:1;
 	unsigned int pullup:1;
+	unsigned int edge_timing:1;
+	unsigned int deferred:1;
+	unsigned int sigma_delta:1;
 } io_caps_t;
 
 assert_size(io_caps_t, 4);
@@ -191,6 +216,14 @@ typedef struct
 			uint16_t		upper_bound;
 		} output_analog;
 
+		struct attr_packed
+		{
+			unsigned int	oversample:3;
+			unsigned int	filter:2;
+			unsigned int	filter_order:3;
+			uint16_t		window;
+		} input_analog;
+
 		struct
 		{
 			io_i2c_t		pin_mode;
@@ -206,9 +239,17 @@ typedef struct
 			config_io_t		io;
 			io_trigger_t	trigger_mode;
 		} trigger;
+
+		struct
+		{
+			int8_t			partner;
+			uint8_t			secondary;
+		} encoder;
 	} shared;
 } io_config_pin_entry_t;
 
+assert_size(io_config_pin_entry_t, 12);
+
 typedef const struct io_info_entry_T
 {
 	uint8_t address;
@@ -222,6 +263,7 @@ typedef const struct io_info_entry_T
 	io_error_t	(* const get_pin_info_fn)	(string_t *error,	const struct io_info_entry_T *, io_data_pin_entry_t *, const io_config_pin_entry_t *, int);
 	io_error_t	(* const read_pin_fn)		(string_t *error,	const struct io_info_entry_T *, io_data_pin_entry_t *, const io_config_pin_entry_t *, int, int *);
 	io_error_t	(* const write_pin_fn)		(string_t *error,	const struct io_info_entry_T *, io_data_pin_entry_t *, const io_config_pin_entry_t *, int, int);
+	io_error_t	(* const flush_fn)			(string_t *error,	const struct io_info_entry_T *);
 } io_info_entry_t;
 
 typedef const io_info_entry_t io_info_t[io_id_size];
@@ -231,10 +273,13 @@ extern io_config_pin_entry_t io_config[io_id_size][max_pins_per_io];
 assert_size(io_error_t, 4);
 
 void		io_init(void);
-void		io_periodic(void);
+bool_t		io_periodic_fast(void);
+bool_t		io_periodic_deferred(void);
+void		io_event_add(int io, int pin, int value, uint32_t timestamp);
 io_error_t	io_read_pin(string_t *, int, int, int *);
 io_error_t	io_write_pin(string_t *, int, int, int);
 io_error_t	io_trigger_pin(string_t *, int, int, io_trigger_t);
+io_error_t	io_flush(string_t *);
 void		io_config_dump(string_t *dst, int io_id, int pin_id, bool html);
 void		io_string_from_ll_mode(string_t *, io_pin_ll_mode_t);
 
@@ -244,5 +289,6 @@ app_action_t application_function_io_write(const string_t *src, string_t *dst);
 app_action_t application_function_io_trigger(const string_t *src, string_t *dst);
 app_action_t application_function_io_set_flag(const string_t *src, string_t *dst);
 app_action_t application_function_io_clear_flag(const string_t *src, string_t *dst);
+app_action_t application_function_io_events(const string_t *src, string_t *dst);
 
 #endif
@@ -16,6 +16,260 @@ irom static void setclear_perireg(uint32_t reg, uint32_t clear, uint32_t set)
     WRITE_PERI_REG(reg, tmp);
 }
 
+// background adc sampler, each sample is the average of 4^oversample conversions, which adds
+// oversample bits of resolution, the result is scaled to 16 bits, like the single reads
+
+typedef struct
+{
+	ETSTimer		timer;
+	bool_t			active;
+	bool_t			primed;
+	unsigned int	oversample;
+	io_adc_filter_t	filter;
+	unsigned int	filter_order;
+	unsigned int	window;
+	uint32_t		samples;
+
+	unsigned int	raw;
+	unsigned int	value;
+	int32_t			exponential; // << 8
+	uint16_t		boxcar[1 << io_aux_adc_max_boxcar_order];
+	unsigned int	boxcar_index;
+	uint32_t		boxcar_sum;
+
+	// window being collected
+
+	unsigned int	count;
+	unsigned int	window_min;
+	unsigned int	window_max;
+	uint64_t		window_sum;
+	uint64_t		window_sum_squares;
+
+	// last complete window
+
+	bool_t			valid;
+	unsigned int	min;
+	unsigned int	max;
+	unsigned int	mean;
+	unsigned int	rms;
+	unsigned int	acrms;
+} adc_sampler_t;
+
+static adc_sampler_t adc_sampler;
+
+irom attr_const static unsigned int adc_sqrt(uint32_t value)
+{
+	uint32_t root, bit;
+
+	root = 0;
+	bit = (uint32_t)1 << 30;
+
+	while(bit > value)
+		bit >>= 2;
+
+	while(bit)
+	{
+		if(value >= (root + bit))
+		{
+			value -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else
+			root >>= 1;
+
+		bit >>= 2;
+	}
+
+	return(root);
+}
+
+irom static void adc_sampler_window_reset(void)
+{
+	adc_sampler.count = 0;
+	adc_sampler.window_min = 0xffff;
+	adc_sampler.window_max = 0;
+	adc_sampler.window_sum = 0;
+	adc_sampler.window_sum_squares = 0;
+}
+
+irom static void adc_sampler_callback(void *arg)
+{
+	uint32_t sum, sample, mean_square;
+	int ix, reads;
+
+	reads = 1 << (adc_sampler.oversample * 2);
+
+	for(ix = 0, sum = 0; ix < reads; ix++)
+		sum += system_adc_read();
+
+	sample = (sum >> adc_sampler.oversample) << (6 - adc_sampler.oversample);
+
+	if(sample > 0xffff)
+		sample = 0xffff;
+
+	if(!adc_sampler.primed)
+	{
+		for(ix = 0; ix < (1 << adc_sampler.filter_order); ix++)
+			adc_sampler.boxcar[ix] = sample;
+
+		adc_sampler.boxcar_sum = sample << adc_sampler.filter_order;
+		adc_sampler.exponential = sample << 8;
+		adc_sampler.primed = true;
+	}
+
+	adc_sampler.raw = sample;
+	adc_sampler.samples++;
+
+	switch(adc_sampler.filter)
+	{
+		case(io_adc_filter_boxcar):
+		{
+			adc_sampler.boxcar_sum -= adc_sampler.boxcar[adc_sampler.boxcar_index];
+			adc_sampler.boxcar_sum += sample;
+			adc_sampler.boxcar[adc_sampler.boxcar_index] = sample;
+			adc_sampler.boxcar_index = (adc_sampler.boxcar_index + 1) & ((1 << adc_sampler.filter_order) - 1);
+			adc_sampler.value = adc_sampler.boxcar_sum >> adc_sampler.filter_order;
+
+			break;
+		}
+
+		case(io_adc_filter_exponential):
+		{
+			adc_sampler.exponential += (((int32_t)sample << 8) - adc_sampler.exponential) >> adc_sampler.filter_order;
+			adc_sampler.value = adc_sampler.exponential >> 8;
+
+			break;
+		}
+
+		default:
+		{
+			adc_sampler.value = sample;
+
+			break;
+		}
+	}
+
+	// statistics are taken from the unfiltered samples, filtering would lower the rms
+
+	if(sample < adc_sampler.window_min)
+		adc_sampler.window_min = sample;
+
+	if(sample > adc_sampler.window_max)
+		adc_sampler.window_max = sample;
+
+	adc_sampler.window_sum += sample;
+	adc_sampler.window_sum_squares += (uint64_t)sample * sample;
+
+	if(++adc_sampler.count < adc_sampler.window)
+		return;
+
+	mean_square = adc_sampler.window_sum_squares / adc_sampler.count;
+
+	adc_sampler.min = adc_sampler.window_min;
+	adc_sampler.max = adc_sampler.window_max;
+	adc_sampler.mean = adc_sampler.window_sum / adc_sampler.count;
+	adc_sampler.rms = adc_sqrt(mean_square);
+
+	// rms of the signal with the dc component removed, i.e. the standard deviation
+
+	if(mean_square > (adc_sampler.mean * adc_sampler.mean))
+		adc_sampler.acrms = adc_sqrt(mean_square - (adc_sampler.mean * adc_sampler.mean));
+	else
+		adc_sampler.acrms = 0;
+
+	adc_sampler.valid = true;
+
+	adc_sampler_window_reset();
+}
+
+irom static void adc_sampler_stop(void)
+{
+	if(adc_sampler.active)
+		ets_timer_disarm(&adc_sampler.timer);
+
+	adc_sampler.active = false;
+}
+
+irom static void adc_sampler_start(const io_config_pin_entry_t *pin_config)
+{
+	adc_sampler_stop();
+
+	adc_sampler.oversample = pin_config->shared.input_analog.oversample;
+	adc_sampler.filter = pin_config->shared.input_analog.filter;
+	adc_sampler.filter_order = pin_config->shared.input_analog.filter_order;
+	adc_sampler.window = pin_config->shared.input_analog.window;
+	adc_sampler.samples = 0;
+	adc_sampler.boxcar_index = 0;
+	adc_sampler.primed = false;
+	adc_sampler.valid = false;
+
+	adc_sampler_window_reset();
+
+	ets_timer_setfn(&adc_sampler.timer, adc_sampler_callback, (void *)0);
+	ets_timer_arm_new(&adc_sampler.timer, 1000000 / pin_config->speed, true, 0);
+
+	adc_sampler.active = true;
+}
+
+typedef struct
+{
+	io_aux_adc_field_t	field;
+	const char			*name;
+} io_aux_adc_field_trait_t;
+
+static const io_aux_adc_field_trait_t io_aux_adc_field_traits[io_aux_adc_size] =
+{
+	{ io_aux_adc_value,	"value"	},
+	{ io_aux_adc_raw,	"raw"	},
+	{ io_aux_adc_min,	"min"	},
+	{ io_aux_adc_max,	"max"	},
+	{ io_aux_adc_mean,	"mean"	},
+	{ io_aux_adc_rms,	"rms"	},
+	{ io_aux_adc_acrms,	"acrms"	},
+};
+
+irom io_aux_adc_field_t io_aux_adc_field_from_string(const string_t *src)
+{
+	int ix;
+
+	for(ix = 0; ix < io_aux_adc_size; ix++)
+		if(string_match(src, io_aux_adc_field_traits[ix].name))
+			return(io_aux_adc_field_traits[ix].field);
+
+	return(io_aux_adc_error);
+}
+
+irom const char *io_aux_adc_field_name(io_aux_adc_field_t field)
+{
+	if((field < 0) || (field >= io_aux_adc_size))
+		return("error");
+
+	return(io_aux_adc_field_traits[field].name);
+}
+
+irom io_adc_filter_t io_aux_adc_filter_from_string(const string_t *src)
+{
+	if(string_match(src, "none"))
+		return(io_adc_filter_none);
+	else if(string_match(src, "box"))
+		return(io_adc_filter_boxcar);
+	else if(string_match(src, "exp"))
+		return(io_adc_filter_exponential);
+	else
+		return(io_adc_filter_error);
+}
+
+irom static const char *adc_filter_to_string(io_adc_filter_t filter)
+{
+	switch(filter)
+	{
+		case(io_adc_filter_none): return("none");
+		case(io_adc_filter_boxcar): return("box");
+		case(io_adc_filter_exponential): return("exp");
+		default: return("error");
+	}
+}
+
 irom attr_const io_error_t io_aux_init(const struct io_info_entry_T *info)
 {
 	return(io_ok);
@@ -69,8 +323,38 @@ irom io_error_t io_aux_init_pin_mode(string_t *error_message, const struct io_in
 		{
 			switch(pin_config->llmode)
 			{
+				case(io_pin_ll_disabled):
+				{
+					adc_sampler_stop();
+
+					break;
+				}
+
 				case(io_pin_ll_input_analog):
 				{
+					// sample rate 0 means single reads on request
+
+					if(pin_config->speed == 0)
+					{
+						adc_sampler_stop();
+						break;
+					}
+
+					if((pin_config->speed > io_aux_adc_max_rate) ||
+							(pin_config->shared.input_analog.oversample > io_aux_adc_max_oversample) ||
+							(pin_config->shared.input_analog.filter >= io_adc_filter_size) ||
+							((pin_config->shared.input_analog.filter == io_adc_filter_boxcar) &&
+								(pin_config->shared.input_analog.filter_order > io_aux_adc_max_boxcar_order)) ||
+							(pin_config->shared.input_analog.window == 0))
+					{
+						if(error_message)
+							string_cat(error_message, "invalid adc sampler settings\n");
+
+						return(io_error);
+					}
+
+					adc_sampler_start(pin_config);
+
 					break;
 				}
 
@@ -114,6 +398,11 @@ irom io_error_t io_aux_get_pin_info(string_t *dst, const struct io_info_entry_T
 		{
 			string_cat(dst, "builtin adc input");
 
+			if(adc_sampler.active)
+				string_format(dst, ", sampling: %u Hz, oversample: %u bits, filter: %s/%u, window: %u, samples: %u",
+						pin_config->speed, adc_sampler.oversample, adc_filter_to_string(adc_sampler.filter),
+						1 << adc_sampler.filter_order, adc_sampler.window, adc_sampler.samples);
+
 			break;
 		}
 
@@ -163,7 +452,10 @@ irom io_error_t io_aux_read_pin(string_t *error_message, const struct io_info_en
 			{
 				case(io_pin_ll_input_analog):
 				{
-					*value = system_adc_read() << 6;
+					if(adc_sampler.active && adc_sampler.primed)
+						*value = adc_sampler.value;
+					else
+						*value = system_adc_read() << 6;
 
 					break;
 				}
@@ -265,3 +557,51 @@ irom io_error_t io_aux_write_pin(string_t *error_message, const struct io_info_e
 
 	return(io_ok);
 }
+
+irom io_error_t io_aux_adc_read_field(string_t *error_message, const io_config_pin_entry_t *pin_config, io_aux_adc_field_t field, int *value)
+{
+	if(pin_config->llmode != io_pin_ll_input_analog)
+	{
+		if(error_message)
+			string_cat(error_message, "invalid mode for this pin\n");
+
+		return(io_error);
+	}
+
+	if(!adc_sampler.active || !adc_sampler.primed)
+	{
+		if(error_message)
+			string_cat(error_message, "adc sampler not running\n");
+
+		return(io_error);
+	}
+
+	if((field >= io_aux_adc_min) && !adc_sampler.valid)
+	{
+		if(error_message)
+			string_cat(error_message, "no complete window yet\n");
+
+		return(io_error);
+	}
+
+	switch(field)
+	{
+		case(io_aux_adc_value): { *value = adc_sampler.value; break; }
+		case(io_aux_adc_raw): { *value = adc_sampler.raw; break; }
+		case(io_aux_adc_min): { *value = adc_sampler.min; break; }
+		case(io_aux_adc_max): { *value = adc_sampler.max; break; }
+		case(io_aux_adc_mean): { *value = adc_sampler.mean; break; }
+		case(io_aux_adc_rms): { *value = adc_sampler.rms; break; }
+		case(io_aux_adc_acrms): { *value = adc_sampler.acrms; break; }
+
+		default:
+		{
+			if(error_message)
+				string_cat(error_message, "invalid field\n");
+
+			return(io_error);
+		}
+	}
+
+	return(io_ok);
+}
@@ -16,10 +16,37 @@ typedef enum
 
 assert_size(io_aux_pin_t, 4);
 
+typedef enum
+{
+	io_aux_adc_value = 0,
+	io_aux_adc_raw,
+	io_aux_adc_min,
+	io_aux_adc_max,
+	io_aux_adc_mean,
+	io_aux_adc_rms,
+	io_aux_adc_acrms,
+	io_aux_adc_error,
+	io_aux_adc_size = io_aux_adc_error
+} io_aux_adc_field_t;
+
+assert_size(io_aux_adc_field_t, 4);
+
+enum
+{
+	io_aux_adc_max_rate = 1000,
+	io_aux_adc_max_oversample = 3,
+	io_aux_adc_max_reads_per_second = 8000,
+	io_aux_adc_max_boxcar_order = 5,
+};
+
 io_error_t	io_aux_init(const struct io_info_entry_T *);
 io_error_t	io_aux_init_pin_mode(string_t *, const struct io_info_entry_T *, io_data_pin_entry_t *, const io_config_pin_entry_t *, int);
 io_error_t	io_aux_get_pin_info(string_t *, const struct io_info_entry_T *, io_data_pin_entry_t *, const io_config_pin_entry_t *, int);
 io_error_t	io_aux_read_pin(string_t *, const struct io_info_entry_T *, io_data_pin_entry_t *, const io_config_pin_entry_t *, int, int *);
 io_error_t	io_aux_write_pin(string_t *, const struct io_info_entry_T *, io_data_pin_entry_t *, const io_config_pin_entry_t *, int, int);
+io_adc_filter_t		io_aux_adc_filter_from_string(const string_t *);
+io_aux_adc_field_t	io_aux_adc_field_from_string(const string_t *);
+const char			*io_aux_adc_field_name(io_aux_adc_field_t);
+io_error_t			io_aux_adc_read_field(string_t *, const io_config_pin_entry_t *, io_aux_adc_field_t, int *);
 
 #endif
@@ -0,0 +1,104 @@
+#include "io_debounce.h"
+
+#include "util.h"
+
+irom void io_debounce_init(io_debounce_t *debounce, uint32_t state)
+{
+	int plane;
+
+	debounce->state = state;
+
+	for(plane = 0; plane < io_debounce_planes; plane++)
+	{
+		debounce->count[plane] = 0;
+		debounce->samples[plane] = (plane == 0) ? ~0 : 0; // one sample = no debouncing
+	}
+}
+
+irom void io_debounce_pin(io_debounce_t *debounce, int pin, int samples, bool_t state)
+{
+	uint32_t mask = 1 << pin;
+	int plane;
+
+	if(samples < 1)
+		samples = 1;
+
+	if(samples > io_debounce_max_samples)
+		samples = io_debounce_max_samples;
+
+	if(state)
+		debounce->state |= mask;
+	else
+		debounce->state &= ~mask;
+
+	for(plane = 0; plane < io_debounce_planes; plane++)
+	{
+		debounce->count[plane] &= ~mask;
+
+		if(samples & (1 << plane))
+			debounce->samples[plane] |= mask;
+		else
+			debounce->samples[plane] &= ~mask;
+	}
+}
+
+// returns the pins that changed debounced state
+
+iram uint32_t io_debounce_sample(io_debounce_t *debounce, uint32_t input)
+{
+	uint32_t differ, carry, next, match;
+	int plane;
+
+	differ = input ^ debounce->state;
+	carry = differ;
+	match = differ;
+
+	// increment the counters of the pins that differ, clear the others,
+	// then check which counters reached their pin's sample count
+
+	for(plane = 0; plane < io_debounce_planes; plane++)
+	{
+		next = (debounce->count[plane] ^ carry) & differ;
+		carry &= debounce->count[plane];
+		debounce->count[plane] = next;
+		match &= ~(next ^ debounce->samples[plane]);
+	}
+
+	debounce->state ^= match;
+
+	for(plane = 0; plane < io_debounce_planes; plane++)
+		debounce->count[plane] &= ~match;
+
+	return(match);
+}
+
+iram bool_t io_debounce_busy(const io_debounce_t *debounce)
+{
+	uint32_t busy;
+	int plane;
+
+	for(plane = 0, busy = 0; plane < io_debounce_planes; plane++)
+		busy |= debounce->count[plane];
+
+	return(!!busy);
+}
+
+// counter pins count on the falling edge, unless configured otherwise
+
+iram bool_t io_debounce_counts(const io_config_pin_entry_t *pin_config, bool_t state)
+{
+	if(!pin_config->flags.rising && !pin_config->flags.falling)
+		return(!state);
+
+	return(state ? pin_config->flags.rising : pin_config->flags.falling);
+}
+
+// only counters are debounced, the debounce time is in ms
+
+irom int io_debounce_samples(const io_config_pin_entry_t *pin_config)
+{
+	if(pin_config->llmode != io_pin_ll_counter)
+		return(1);
+
+	return((pin_config->speed + io_debounce_sample_ms - 1) / io_debounce_sample_ms);
+}
@@ -0,0 +1,34 @@
+#ifndef io_debounce_h
+#define io_debounce_h
+
+#include "io.h"
+#include "util.h"
+
+#include <stdint.h>
+
+// integrator debounce for a whole port at once, every pin has an 8 bit counter, stored as
+// bit planes, that counts the consecutive samples that differ from the debounced state
+
+enum
+{
+	io_debounce_planes = 8,
+	io_debounce_max_samples = (1 << io_debounce_planes) - 1,
+	io_debounce_sample_ms = 10,
+	io_debounce_max_ms = io_debounce_max_samples * io_debounce_sample_ms,
+};
+
+typedef struct
+{
+	uint32_t	state;
+	uint32_t	count[io_debounce_planes];
+	uint32_t	samples[io_debounce_planes];
+} io_debounce_t;
+
+void		io_debounce_init(io_debounce_t *, uint32_t state);
+void		io_debounce_pin(io_debounce_t *, int pin, int samples, bool_t state);
+uint32_t	io_debounce_sample(io_debounce_t *, uint32_t input);
+bool_t		io_debounce_busy(const io_debounce_t *);
+bool_t		io_debounce_counts(const io_config_pin_entry_t *, bool_t state);
+int			io_debounce_samples(const io_config_pin_entry_t *);
+
+#endif
@@ -2,6 +2,7 @@
 
 #include "stats.h"
 #include "util.h"
+#include "io_debounce.h"
 
 #include <user_interface.h>
 #include <osapi.h>
@@ -46,10 +47,37 @@ enum
 	FRC1_NMI_SOURCE = 0x8000
 };
 
+// interrupt type field in GPIO_PINx register
+
+enum
+{
+	gpio_pin_intr_shift = 7,
+	gpio_pin_intr_mask = 0x07 << gpio_pin_intr_shift,
+};
+
+// pin source field in GPIO_PINx register and the sigma-delta modulator register
+
+enum
+{
+	gpio_pin_source_sigma_delta = 1 << 0,
+	gpio_sigma_delta_address = 0x68,
+	gpio_sigma_delta_enable = 1 << 16,
+	gpio_sigma_delta_prescale_shift = 8,
+	gpio_sigma_delta_max = 0xff,
+};
+
+typedef enum
+{
+	gpio_pin_intr_disable = 0,
+	gpio_pin_intr_posedge = 1,
+	gpio_pin_intr_negedge = 2,
+	gpio_pin_intr_anyedge = 3,
+} gpio_pin_intr_t;
+
 enum
 {
 	io_gpio_pin_size = 16,
-	io_gpio_pwm_max_channels = 4,
+	io_gpio_pwm_max_channels = io_gpio_pin_size, // every pin can be a channel, there is one phase per distinct duty
 };
 
 typedef enum
@@ -73,21 +101,63 @@ typedef union
 	struct
 	{
 		unsigned int counter;
-		unsigned int debounce;
+		unsigned int reported;
+		uint32_t debounce;
+		uint32_t last_edge;
 	} counter;
 
+	struct
+	{
+		unsigned int edges;
+		uint32_t gate_start;
+		unsigned int frequency;
+	} frequency;
+
+	struct
+	{
+		uint32_t last_edge;
+		unsigned int high;
+		unsigned int low;
+	} pulse;
+
+	struct
+	{
+		int position;
+		int last_position;
+		int velocity;
+		uint32_t window_start;
+		unsigned int state;
+	} encoder;
+
 	struct
 	{
 		int this;
 		int next;
 		unsigned int duty;
+		int32_t fade_level; // perceptual level << 8
+		int32_t fade_step;
+		unsigned int fade_target;
+		unsigned int fade_steps;
 	} pwm;
 } gpio_data_pin_t;
 
-static uint32_t gpio_pc_pins_previous;
 static gpio_data_pin_t gpio_data[io_gpio_pin_size];
+static uint32_t gpio_edge_mask;
+static io_debounce_t gpio_debounce;
 static uint32_t pwm_static_set_mask;
 static uint32_t pwm_static_clear_mask;
+static bool_t sequence_active;
+
+// quadrature decoding, index is previous state << 2 | new state, state is a << 1 | b,
+// invalid transitions (both pins changed) don't count
+
+static const int8_t encoder_table[16] =
+{
+	 0, +1, -1,  0,
+	-1,  0,  0, +1,
+	+1,  0,  0, -1,
+	 0, -1, +1,  0,
+};
 
 static gpio_info_t gpio_info_table[io_gpio_pin_size] =
 {
@@ -201,6 +271,141 @@ irom static bool_t gpio_func_select(int pin, int func)
 	return(true);
 }
 
+// sigma-delta modulator, there is only one, all pins using it share the same target (density)
+
+static unsigned int sigma_delta_target;
+static unsigned int sigma_delta_prescale;
+
+irom static void gpio_sigma_delta_update(void)
+{
+	io_config_pin_entry_t *pin_config;
+	int pin;
+
+	for(pin = 0; pin < io_gpio_pin_size; pin++)
+	{
+		pin_config = &io_config[io_id_gpio][pin];
+
+		if(gpio_info_table[pin].valid && (pin_config->llmode == io_pin_ll_output_sigma_delta))
+			break;
+	}
+
+	if(pin < io_gpio_pin_size)
+		gpio_reg_write(gpio_sigma_delta_address, gpio_sigma_delta_enable |
+				(sigma_delta_prescale << gpio_sigma_delta_prescale_shift) | sigma_delta_target);
+	else
+		gpio_reg_write(gpio_sigma_delta_address, 0);
+}
+
+irom static void gpio_sigma_delta_source(int pin, bool_t enable)
+{
+	uint32_t value;
+
+	value = gpio_reg_read(gpio_pin_addr(pin));
+
+	if(enable)
+		value |= gpio_pin_source_sigma_delta;
+	else
+		value &= ~gpio_pin_source_sigma_delta;
+
+	gpio_reg_write(gpio_pin_addr(pin), value);
+}
+
+// edge interrupts
+
+irom static void gpio_pin_intr(int pin, gpio_pin_intr_t type)
+{
+	uint32_t value;
+
+	value = gpio_reg_read(gpio_pin_addr(pin));
+	value &= ~gpio_pin_intr_mask;
+	value |= type << gpio_pin_intr_shift;
+	gpio_reg_write(gpio_pin_addr(pin), value);
+
+	gpio_reg_write(GPIO_STATUS_W1TC_ADDRESS, 1 << pin);
+}
+
+iram static void gpio_isr(void *arg)
+{
+	gpio_data_pin_t *gpio_pin_data;
+	uint32_t status, now;
+	int pin;
+
+	status = gpio_reg_read(GPIO_STATUS_ADDRESS);
+	gpio_reg_write(GPIO_STATUS_W1TC_ADDRESS, status);
+
+	now = system_get_time();
+
+	stat_gpio_interrupts++;
+
+	for(pin = 0, status &= gpio_edge_mask; status; pin++, status >>= 1)
+	{
+		if(!(status & 1))
+			continue;
+
+		gpio_pin_data = &gpio_data[pin];
+
+		switch(io_config[io_id_gpio][pin].llmode)
+		{
+			case(io_pin_ll_counter):
+			{
+				// edges within the debounce time after a counted edge are contact bounce
+
+				if((now - gpio_pin_data->counter.last_edge) < gpio_pin_data->counter.debounce)
+					break;
+
+				gpio_pin_data->counter.counter++;
+				gpio_pin_data->counter.last_edge = now;
+
+				break;
+			}
+
+			case(io_pin_ll_frequency):
+			{
+				gpio_pin_data->frequency.edges++;
+
+				break;
+			}
+
+			case(io_pin_ll_pulse_width):
+			{
+				// the level after the edge tells which half period just ended
+
+				if(gpio_get(pin))
+					gpio_pin_data->pulse.low = now - gpio_pin_data->pulse.last_edge;
+				else
+					gpio_pin_data->pulse.high = now - gpio_pin_data->pulse.last_edge;
+
+				gpio_pin_data->pulse.last_edge = now;
+
+				break;
+			}
+
+			case(io_pin_ll_encoder):
+			{
+				const io_config_pin_entry_t *pin_config = &io_config[io_id_gpio][pin];
+				unsigned int state;
+				int primary;
+
+				// all state is kept with pin a
+
+				primary = pin_config->shared.encoder.secondary ? pin_config->shared.encoder.partner : pin;
+				gpio_pin_data = &gpio_data[primary];
+
+				state = (gpio_get(primary) << 1) | gpio_get(io_config[io_id_gpio][primary].shared.encoder.partner);
+				gpio_pin_data->encoder.position += encoder_table[(gpio_pin_data->encoder.state << 2) | state];
+				gpio_pin_data->encoder.state = state;
+
+				break;
+			}
+
+			default:
+			{
+				break;
+			}
+		}
+	}
+}
+
 // PWM
 
 typedef struct
@@ -227,6 +432,7 @@ static pwm_phases_t		pwm_phase[2];
 static io_gpio_flags_t	io_gpio_flags;
 
 static int pwm_head;
+static bool_t pwm_pending; // phase set couldn't be rebuilt yet, retry on the next tick
 
 iram static inline bool_t pwm_isr_enabled(void)
 {
@@ -321,12 +527,16 @@ irom static bool_t pwm_go(void)
 	pwm_phases_t *phase_data;
 	unsigned int duty, delta, new_set, pwm_period;
 
-	if(!config_get_int("pwm.period", -1, -1, &pwm_period))
-		pwm_period = 65536;
+	pwm_period = config_runtime_get()->pwm_period;
 
 	if(io_gpio_flags.pwm_swap_phase_set)
 		return(false);
 
+	if(sequence_active) // timer in use, called again when the sequence ends
+		return(false);
+
+	stat_pwm_phase_builds++;
+
 	new_set = pwm_current_phase_set;
 
 	if(pwm_isr_enabled())
@@ -435,6 +645,8 @@ irom static bool_t pwm_go(void)
 	phase_data->phase[0].mask = 0x0000;
 	phase_data->size = 1;
 
+	// channels with the same duty share one phase, so the isr cost depends on the number of distinct duty values
+
 	for(pin1 = pwm_head, duty = 0; (phase_data->size < (io_gpio_pwm_max_channels + 1)) && (pin1 >= 0); pin1 = pin1_data->pwm.next)
 	{
 		pin1_data = &gpio_data[pin1];
@@ -483,11 +695,258 @@ irom static bool_t pwm_go(void)
 	return(true);
 }
 
+// fading, channels move from their current to a target perceptual level (0-65535) in steps of one
+// tick, the level is converted to a duty using a gamma 2.2 table, so steps at low brightness are
+// small enough not to be visible, all channels are updated with one phase set rebuild per tick
+
+enum
+{
+	pwm_fade_tick_ms = 10,
+	pwm_gamma_shift = 10,
+};
+
+static roflash const uint32_t pwm_gamma_table[(65536 >> pwm_gamma_shift) + 1] =
+{
+	    0,     7,    32,    78,   147,   240,   359,   504,
+	  676,   875,  1104,  1361,  1648,  1966,  2314,  2693,
+	 3104,  3547,  4022,  4530,  5072,  5646,  6255,  6897,
+	 7574,  8286,  9033,  9815, 10632, 11486, 12375, 13301,
+	14263, 15262, 16298, 17371, 18482, 19630, 20816, 22040,
+	23303, 24604, 25943, 27322, 28739, 30196, 31692, 33227,
+	34802, 36417, 38072, 39768, 41503, 43280, 45097, 46954,
+	48853, 50793, 52774, 54796, 56860, 58966, 61114, 63303,
+	65535,
+};
+
+irom static unsigned int pwm_gamma(unsigned int level, unsigned int pwm_period)
+{
+	unsigned int index, fraction, low, high, linear;
+
+	index = level >> pwm_gamma_shift;
+	fraction = level & ((1 << pwm_gamma_shift) - 1);
+	low = pwm_gamma_table[index];
+	high = pwm_gamma_table[index + 1];
+
+	linear = low + (((high - low) * fraction) >> pwm_gamma_shift);
+
+	return((linear * (pwm_period - 1)) / 65535);
+}
+
+irom static void pwm_fade_start(int pin, unsigned int target, unsigned int duration)
+{
+	gpio_data_pin_t *gpio_pin_data = &gpio_data[pin];
+	unsigned int steps, low, high, middle, pwm_period;
+
+	// the duty may have been written directly, start from the level that matches it
+
+	pwm_period = config_runtime_get()->pwm_period;
+
+	if((gpio_pin_data->pwm.fade_steps == 0) &&
+			(pwm_gamma(gpio_pin_data->pwm.fade_level >> 8, pwm_period) != gpio_pin_data->pwm.duty))
+	{
+		for(low = 0, high = 65535; low < high;)
+		{
+			middle = (low + high) / 2;
+
+			if(pwm_gamma(middle, pwm_period) < gpio_pin_data->pwm.duty)
+				low = middle + 1;
+			else
+				high = middle;
+		}
+
+		gpio_pin_data->pwm.fade_level = low << 8;
+	}
+
+	steps = duration / pwm_fade_tick_ms;
+
+	if(steps == 0)
+		steps = 1;
+
+	gpio_pin_data->pwm.fade_target = target;
+	gpio_pin_data->pwm.fade_step = (((int32_t)target << 8) - gpio_pin_data->pwm.fade_level) / (int32_t)steps;
+	gpio_pin_data->pwm.fade_steps = steps;
+}
+
+iram static bool_t pwm_fade_tick(gpio_data_pin_t *gpio_pin_data, unsigned int pwm_period)
+{
+	unsigned int duty;
+
+	if(gpio_pin_data->pwm.fade_steps == 0)
+		return(false);
+
+	if(--gpio_pin_data->pwm.fade_steps == 0)
+		gpio_pin_data->pwm.fade_level = gpio_pin_data->pwm.fade_target << 8;
+	else
+		gpio_pin_data->pwm.fade_level += gpio_pin_data->pwm.fade_step;
+
+	duty = pwm_gamma(gpio_pin_data->pwm.fade_level >> 8, pwm_period);
+
+	if(duty == gpio_pin_data->pwm.duty)
+		return(false);
+
+	gpio_pin_data->pwm.duty = duty;
+
+	return(true);
+}
+
+// sequence playback, uses the FRC1 timer, so it can't run together with PWM
+
+enum
+{
+	sequence_size = 30,
+	sequence_ticks_per_us = 5, // 80 MHz / 16
+	sequence_max_ticks = 0x7fffff,
+	sequence_min_duration = 10,
+	sequence_max_duration = 0xffffffffU / sequence_ticks_per_us, // the duration in ticks must fit in 32 bits
+};
+
+typedef struct
+{
+	uint32_t	mask;
+	uint32_t	duration;
+} sequence_step_t;
+
+assert_size(sequence_step_t, 8);
+
+static sequence_step_t sequence_table[sequence_size];
+static unsigned int sequence_length;
+static uint32_t sequence_group_mask;
+static unsigned int sequence_step;
+static unsigned int sequence_repeat;
+static uint32_t sequence_remaining;
+static volatile bool_t sequence_running;
+
+iram static void sequence_isr(void)
+{
+	const sequence_step_t *step;
+	uint32_t ticks;
+
+	stat_sequence_timer_interrupts++;
+
+	if(sequence_remaining == 0)
+	{
+		if(sequence_step >= sequence_length)
+		{
+			sequence_step = 0;
+
+			if((sequence_repeat > 0) && (--sequence_repeat == 0))
+			{
+				pwm_isr_enable(false);
+				sequence_running = false;
+				return;
+			}
+		}
+
+		step = &sequence_table[sequence_step++];
+
+		gpio_set_mask(step->mask & sequence_group_mask);
+		gpio_clear_mask(~step->mask & sequence_group_mask);
+
+		sequence_remaining = step->duration * sequence_ticks_per_us;
+	}
+
+	// steps longer than the timer can handle are split
+
+	if(sequence_remaining > sequence_max_ticks)
+		ticks = sequence_max_ticks;
+	else
+		ticks = sequence_remaining;
+
+	sequence_remaining -= ticks;
+
+	pwm_timer_reload(ticks);
+}
+
+irom static void sequence_release(void)
+{
+	pwm_isr_enable(false);
+	sequence_running = false;
+	sequence_active = false;
+
+	ets_isr_attach(ETS_FRC_TIMER1_INUM, pwm_isr, 0);
+	pwm_go();
+}
+
+irom static bool_t sequence_start(string_t *error, unsigned int repeat)
+{
+	unsigned int step;
+	int pin;
+
+	if(sequence_length == 0)
+	{
+		string_cat(error, "sequence empty\n");
+		return(false);
+	}
+
+	if(sequence_active)
+		sequence_release();
+
+	if(pwm_isr_enabled())
+	{
+		string_cat(error, "pwm active, sequence playback needs the pwm timer\n");
+		return(false);
+	}
+
+	for(step = 0, sequence_group_mask = 0; step < sequence_length; step++)
+		sequence_group_mask |= sequence_table[step].mask;
+
+	for(pin = 0; pin < io_gpio_pin_size; pin++)
+	{
+		if(!(sequence_group_mask & (1 << pin)))
+			continue;
+
+		if(!gpio_info_table[pin].valid || (io_config[io_id_gpio][pin].llmode != io_pin_ll_output_digital))
+		{
+			string_format(error, "gpio %d is not a digital output\n", pin);
+			return(false);
+		}
+	}
+
+	sequence_step = 0;
+	sequence_remaining = 0;
+	sequence_repeat = repeat;
+	sequence_running = true;
+	sequence_active = true;
+
+	ets_isr_attach(ETS_FRC_TIMER1_INUM, sequence_isr, 0);
+	pwm_isr_enable(true);
+	pwm_timer_reload(32);
+
+	return(true);
+}
+
 // other
 
 irom io_error_t io_gpio_init(const struct io_info_entry_T *info)
 {
-	gpio_pc_pins_previous = gpio_get_mask(); // init pin change notification
+	int length, step, prescale;
+
+	gpio_edge_mask = 0;
+	io_debounce_init(&gpio_debounce, gpio_get_mask());
+
+	sequence_running = false;
+	sequence_active = false;
+
+	if(!config_get_int("gpio.sequence.length", -1, -1, &length) || (length < 0) || (length > sequence_size) ||
+			!config_get_blob("gpio.sequence", -1, -1, sequence_table, length * sizeof(*sequence_table)))
+		length = 0;
+
+	for(step = 0; step < length; step++)
+		if((sequence_table[step].duration < sequence_min_duration) || (sequence_table[step].duration > sequence_max_duration))
+			length = 0;
+
+	sequence_length = length;
+
+	if(!config_get_int("gpio.sigmadelta.prescale", -1, -1, &prescale) || (prescale < 0) || (prescale > gpio_sigma_delta_max))
+		prescale = 0;
+
+	sigma_delta_prescale = prescale;
+
+	sigma_delta_target = 0;
+
+	ets_isr_mask(1 << ETS_GPIO_INUM);
+	ets_isr_attach(ETS_GPIO_INUM, gpio_isr, 0);
+	ets_isr_unmask(1 << ETS_GPIO_INUM);
 
 	pwm_current_phase_set = 0;
 	io_gpio_flags.pwm_swap_phase_set = 0;
@@ -507,39 +966,125 @@ iram void io_gpio_periodic(int io, const struct io_info_entry_T *info, io_data_e
 {
 	io_config_pin_entry_t *pin_config;
 	gpio_data_pin_t *gpio_pin_data;
+	uint32_t now, elapsed, state, changed;
+	unsigned int pwm_period, edges;
 	int pin;
-	uint32_t gpio_pc_pins_current;
 
-	gpio_pc_pins_current = gpio_get_mask();
+	// hand the timer back to pwm when a sequence has finished
+
+	if(sequence_active && !sequence_running)
+		sequence_release();
+
+	// counters are counted from the edge interrupt, inputs are sampled here
+
+	pwm_period = config_runtime_get()->pwm_period;
+	now = system_get_time();
+	changed = io_debounce_sample(&gpio_debounce, gpio_get_mask());
+	state = gpio_debounce.state;
 
 	for(pin = 0; pin < io_gpio_pin_size; pin++)
 	{
 		pin_config = &io_config[io][pin];
+		gpio_pin_data = &gpio_data[pin];
 
-		if(pin_config->llmode == io_pin_ll_counter)
+		switch(pin_config->llmode)
 		{
-			gpio_pin_data = &gpio_data[pin];
+			case(io_pin_ll_input_digital):
+			{
+				if(changed & (1 << pin))
+					io_event_add(io, pin, !!(state & (1 << pin)), now);
+
+				break;
+			}
 
-			if((gpio_pin_data->counter.debounce == 0))
+			case(io_pin_ll_counter):
 			{
-				if((gpio_pc_pins_previous & (1 << pin)) && !(gpio_pc_pins_current & (1 << pin)))
+				if(gpio_pin_data->counter.reported != gpio_pin_data->counter.counter)
 				{
-					gpio_pin_data->counter.counter++;
-					gpio_pin_data->counter.debounce = pin_config->speed;
+					gpio_pin_data->counter.reported = gpio_pin_data->counter.counter;
+					io_event_add(io, pin, gpio_pin_data->counter.counter, gpio_pin_data->counter.last_edge);
 					flags->counter_triggered = 1;
 				}
+
+				break;
 			}
-			else
+
+			case(io_pin_ll_frequency):
 			{
-				if(gpio_pin_data->counter.debounce >= 10)
-					gpio_pin_data->counter.debounce -= 10; // 10 ms per tick
-				else
-					gpio_pin_data->counter.debounce = 0;
+				elapsed = now - gpio_pin_data->frequency.gate_start;
+
+				if(elapsed >= (pin_config->speed * 1000U))
+				{
+					// the edge count is read and cleared while the edge interrupt can't change it
+
+					ets_isr_mask(1 << ETS_GPIO_INUM);
+					edges = gpio_pin_data->frequency.edges;
+					gpio_pin_data->frequency.edges = 0;
+					ets_isr_unmask(1 << ETS_GPIO_INUM);
+
+					gpio_pin_data->frequency.frequency = ((uint64_t)edges * 1000000) / elapsed;
+					gpio_pin_data->frequency.gate_start = now;
+				}
+
+				break;
+			}
+
+			case(io_pin_ll_pulse_width):
+			{
+				// no edges for longer than the timeout, the signal has stopped
+
+				ets_isr_mask(1 << ETS_GPIO_INUM);
+
+				if((system_get_time() - gpio_pin_data->pulse.last_edge) > (pin_config->speed * 1000U))
+				{
+					gpio_pin_data->pulse.high = 0;
+					gpio_pin_data->pulse.low = 0;
+				}
+
+				ets_isr_unmask(1 << ETS_GPIO_INUM);
+
+				break;
+			}
+
+			case(io_pin_ll_encoder):
+			{
+				int position;
+
+				if(pin_config->shared.encoder.secondary)
+					break;
+
+				elapsed = now - gpio_pin_data->encoder.window_start;
+
+				if(elapsed >= (pin_config->speed * 1000U))
+				{
+					position = gpio_pin_data->encoder.position;
+					gpio_pin_data->encoder.velocity = ((int64_t)(position - gpio_pin_data->encoder.last_position) * 1000000) / (int32_t)elapsed;
+					gpio_pin_data->encoder.last_position = position;
+					gpio_pin_data->encoder.window_start = now;
+				}
+
+				break;
+			}
+
+			case(io_pin_ll_output_analog):
+			{
+				if(pwm_fade_tick(gpio_pin_data, pwm_period))
+					pwm_pending = true;
+
+				break;
+			}
+
+			default:
+			{
+				break;
 			}
 		}
 	}
 
-	gpio_pc_pins_previous = gpio_pc_pins_current;
+	// the new phase set is activated by the isr at the start of the next pwm period
+
+	if(pwm_pending && pwm_go())
+		pwm_pending = false;
 }
 
 irom io_error_t io_gpio_init_pin_mode(string_t *error_message, const struct io_info_entry_T *info, io_data_pin_entry_t *pin_data, const io_config_pin_entry_t *pin_config, int pin)
@@ -554,6 +1099,11 @@ irom io_error_t io_gpio_init_pin_mode(string_t *error_message, const struct io_i
 		return(io_error);
 	}
 
+	gpio_edge_mask &= ~(1 << pin);
+	gpio_pin_intr(pin, gpio_pin_intr_disable);
+	gpio_sigma_delta_source(pin, pin_config->llmode == io_pin_ll_output_sigma_delta);
+	gpio_sigma_delta_update();
+
 	if(pin_config->llmode == io_pin_ll_disabled)
 	{
 		if(error_message)
@@ -573,15 +1123,97 @@ irom io_error_t io_gpio_init_pin_mode(string_t *error_message, const struct io_i
 			gpio_direction(pin, 0);
 			gpio_pullup(pin, pin_config->flags.pullup);
 
+			io_debounce_pin(&gpio_debounce, pin, 1, gpio_get(pin));
+
+			// counters count from the edge interrupt, the debounce time is a lockout
+			// after each counted edge, with us resolution
+
 			if(pin_config->llmode == io_pin_ll_counter)
 			{
 				gpio_pin_data->counter.counter = 0;
-				gpio_pin_data->counter.debounce = 0;
+				gpio_pin_data->counter.reported = 0;
+				gpio_pin_data->counter.debounce = pin_config->speed * 1000;
+				gpio_pin_data->counter.last_edge = system_get_time() - gpio_pin_data->counter.debounce;
+
+				gpio_edge_mask |= 1 << pin;
+
+				// default is falling edge, as before
+
+				if(pin_config->flags.rising && pin_config->flags.falling)
+					gpio_pin_intr(pin, gpio_pin_intr_anyedge);
+				else
+					if(pin_config->flags.rising)
+						gpio_pin_intr(pin, gpio_pin_intr_posedge);
+					else
+						gpio_pin_intr(pin, gpio_pin_intr_negedge);
 			}
 
 			break;
 		}
 
+		case(io_pin_ll_frequency):
+		{
+			gpio_direction(pin, 0);
+			gpio_pullup(pin, pin_config->flags.pullup);
+
+			gpio_pin_data->frequency.edges = 0;
+			gpio_pin_data->frequency.gate_start = system_get_time();
+			gpio_pin_data->frequency.frequency = 0;
+
+			gpio_edge_mask |= 1 << pin;
+			gpio_pin_intr(pin, gpio_pin_intr_posedge);
+
+			break;
+		}
+
+		case(io_pin_ll_pulse_width):
+		{
+			gpio_direction(pin, 0);
+			gpio_pullup(pin, pin_config->flags.pullup);
+
+			gpio_pin_data->pulse.last_edge = system_get_time();
+			gpio_pin_data->pulse.high = 0;
+			gpio_pin_data->pulse.low = 0;
+
+			gpio_edge_mask |= 1 << pin;
+			gpio_pin_intr(pin, gpio_pin_intr_anyedge);
+
+			break;
+		}
+
+		case(io_pin_ll_encoder):
+		{
+			int primary, partner;
+
+			gpio_direction(pin, 0);
+			gpio_pullup(pin, pin_config->flags.pullup);
+
+			if(pin_config->shared.encoder.secondary)
+			{
+				primary = pin_config->shared.encoder.partner;
+				partner = pin;
+			}
+			else
+			{
+				primary = pin;
+				partner = pin_config->shared.encoder.partner;
+
+				gpio_pin_data->encoder.position = 0;
+				gpio_pin_data->encoder.last_position = 0;
+				gpio_pin_data->encoder.velocity = 0;
+				gpio_pin_data->encoder.window_start = system_get_time();
+			}
+
+			ets_isr_mask(1 << ETS_GPIO_INUM);
+			gpio_data[primary].encoder.state = (gpio_get(primary) << 1) | gpio_get(partner);
+			ets_isr_unmask(1 << ETS_GPIO_INUM);
+
+			gpio_edge_mask |= 1 << pin;
+			gpio_pin_intr(pin, gpio_pin_intr_anyedge);
+
+			break;
+		}
+
 		case(io_pin_ll_output_digital):
 		{
 			gpio_direction(pin, 1);
@@ -592,12 +1224,21 @@ irom io_error_t io_gpio_init_pin_mode(string_t *error_message, const struct io_i
 		{
 			gpio_direction(pin, 1);
 			gpio_pin_data->pwm.duty = 0;
+			gpio_pin_data->pwm.fade_level = 0;
+			gpio_pin_data->pwm.fade_steps = 0;
 			gpio_set(pin, 0);
 			pwm_go();
 
 			break;
 		}
 
+		case(io_pin_ll_output_sigma_delta):
+		{
+			gpio_direction(pin, 1);
+
+			break;
+		}
+
 		case(io_pin_ll_i2c):
 		{
 			gpio_direction(pin, 0);
@@ -643,8 +1284,7 @@ irom io_error_t io_gpio_get_pin_info(string_t *dst, const struct io_info_entry_T
 	gpio_data_pin_t *gpio_pin_data;
 	unsigned int pwm_period;
 
-	if(!config_get_int("pwm.period", -1, -1, &pwm_period))
-		pwm_period = 65536;
+	pwm_period = config_runtime_get()->pwm_period;
 
 	gpio_pin_data = &gpio_data[pin];
 
@@ -656,8 +1296,36 @@ irom io_error_t io_gpio_get_pin_info(string_t *dst, const struct io_info_entry_T
 		{
 			case(io_pin_ll_counter):
 			{
-				string_format(dst, "current state: %s, debounce delay: %d",
-						onoff(gpio_get(pin)), gpio_pin_data->counter.debounce);
+				string_format(dst, "current state: %s, debounce: %u ms, last edge: %u us ago",
+						onoff(gpio_get(pin)), pin_config->speed,
+						system_get_time() - gpio_pin_data->counter.last_edge);
+
+				break;
+			}
+
+			case(io_pin_ll_frequency):
+			{
+				string_format(dst, "current state: %s, frequency: %u Hz, gate: %u ms",
+						onoff(gpio_get(pin)), gpio_pin_data->frequency.frequency, pin_config->speed);
+
+				break;
+			}
+
+			case(io_pin_ll_pulse_width):
+			{
+				string_format(dst, "current state: %s, high: %u us, low: %u us",
+						onoff(gpio_get(pin)), gpio_pin_data->pulse.high, gpio_pin_data->pulse.low);
+
+				break;
+			}
+
+			case(io_pin_ll_encoder):
+			{
+				if(pin_config->shared.encoder.secondary)
+					gpio_pin_data = &gpio_data[pin_config->shared.encoder.partner];
+
+				string_format(dst, "current state: %s, position: %d, velocity: %d /s, window: %u ms",
+						onoff(gpio_get(pin)), gpio_pin_data->encoder.position, gpio_pin_data->encoder.velocity, pin_config->speed);
 
 				break;
 			}
@@ -676,8 +1344,23 @@ irom io_error_t io_gpio_get_pin_info(string_t *dst, const struct io_info_entry_T
 				if(!pwm_isr_enabled())
 					frequency = 0;
 
-				string_format(dst, "frequency: %u Hz, duty: %u (%u.%02u %%), state: %s",
-						frequency, duty, dutypct, dutypctfraction, onoff(gpio_get(pin)));
+				string_format(dst, "frequency: %u Hz, duty: %u (%u.%02u %%), state: %s, phases: %u",
+						frequency, duty, dutypct, dutypctfraction, onoff(gpio_get(pin)), pwm_phase[pwm_current_phase_set].size);
+
+				if(gpio_pin_data->pwm.fade_steps > 0)
+					string_format(dst, ", fade: level: %u, target: %u, remaining: %u ms",
+							gpio_pin_data->pwm.fade_level >> 8, gpio_pin_data->pwm.fade_target,
+							gpio_pin_data->pwm.fade_steps * pwm_fade_tick_ms);
+
+				break;
+			}
+
+			case(io_pin_ll_output_sigma_delta):
+			{
+				// the modulator runs at 80 MHz / (prescale + 1), the output density is target / 256
+
+				string_format(dst, "sigma-delta, target: %u (shared), prescale: %u, clock: %u kHz",
+						sigma_delta_target, sigma_delta_prescale, 80000 / (sigma_delta_prescale + 1));
 
 				break;
 			}
@@ -699,6 +1382,16 @@ irom io_error_t io_gpio_get_pin_info(string_t *dst, const struct io_info_entry_T
 	return(io_ok);
 }
 
+// for other ios that read a gpio as their interrupt line
+
+irom bool_t io_gpio_input_digital(int pin)
+{
+	if((pin < 0) || (pin >= io_gpio_pin_size) || !gpio_info_table[pin].valid)
+		return(false);
+
+	return(io_config[io_id_gpio][pin].llmode == io_pin_ll_input_digital);
+}
+
 iram io_error_t io_gpio_read_pin(string_t *error_message, const struct io_info_entry_T *info, io_data_pin_entry_t *pin_data, const io_config_pin_entry_t *pin_config, int pin, int *value)
 {
 	gpio_data_pin_t *gpio_pin_data;
@@ -730,6 +1423,35 @@ iram io_error_t io_gpio_read_pin(string_t *error_message, const struct io_info_e
 			break;
 		}
 
+		case(io_pin_ll_frequency):
+		{
+			*value = gpio_pin_data->frequency.frequency;
+
+			break;
+		}
+
+		case(io_pin_ll_pulse_width):
+		{
+			if(pin_config->direction == io_dir_down)
+				*value = gpio_pin_data->pulse.low;
+			else
+				*value = gpio_pin_data->pulse.high;
+
+			break;
+		}
+
+		case(io_pin_ll_encoder):
+		{
+			// pin a reads the position, pin b the velocity
+
+			if(pin_config->shared.encoder.secondary)
+				*value = gpio_data[pin_config->shared.encoder.partner].encoder.velocity;
+			else
+				*value = gpio_pin_data->encoder.position;
+
+			break;
+		}
+
 		case(io_pin_ll_output_analog):
 		{
 			*value = gpio_pin_data->pwm.duty;
@@ -737,6 +1459,13 @@ iram io_error_t io_gpio_read_pin(string_t *error_message, const struct io_info_e
 			break;
 		}
 
+		case(io_pin_ll_output_sigma_delta):
+		{
+			*value = sigma_delta_target;
+
+			break;
+		}
+
 		default:
 		{
 			if(error_message)
@@ -751,7 +1480,6 @@ iram io_error_t io_gpio_read_pin(string_t *error_message, const struct io_info_e
 iram io_error_t io_gpio_write_pin(string_t *error_message, const struct io_info_entry_T *info, io_data_pin_entry_t *pin_data, const io_config_pin_entry_t *pin_config, int pin, int value)
 {
 	gpio_data_pin_t *gpio_pin_data;
-	int saved_value;
 
 	if(!gpio_info_table[pin].valid)
 	{
@@ -766,7 +1494,26 @@ iram io_error_t io_gpio_write_pin(string_t *error_message, const struct io_info_
 	{
 		case(io_pin_ll_counter):
 		{
+			ets_isr_mask(1 << ETS_GPIO_INUM);
 			gpio_pin_data->counter.counter = value;
+			gpio_pin_data->counter.reported = value;
+			ets_isr_unmask(1 << ETS_GPIO_INUM);
+			break;
+		}
+
+		case(io_pin_ll_encoder):
+		{
+			if(pin_config->shared.encoder.secondary)
+			{
+				if(error_message)
+					string_cat(error_message, "cannot write to encoder pin b\n");
+				return(io_error);
+			}
+
+			ets_isr_mask(1 << ETS_GPIO_INUM);
+			gpio_pin_data->encoder.position = value;
+			gpio_pin_data->encoder.last_position = value;
+			ets_isr_unmask(1 << ETS_GPIO_INUM);
 			break;
 		}
 
@@ -783,19 +1530,38 @@ iram io_error_t io_gpio_write_pin(string_t *error_message, const struct io_info_
 			if(value < 0)
 				value = 0;
 
+			// a direct write cancels a fade in progress
+
+			gpio_pin_data->pwm.fade_steps = 0;
+
 			if(gpio_pin_data->pwm.duty != (unsigned int)value)
 			{
-				saved_value = value;
 				gpio_pin_data->pwm.duty = value;
 
-				if(!pwm_go())
-					gpio_pin_data->pwm.duty = saved_value;
+				// a running ramp writes every tick, leave it to the one rebuild per tick in io_gpio_periodic
+
+				if((pin_data->direction != io_dir_none) || !pwm_go())
+					pwm_pending = true;
 			}
 
 			break;
 
 		}
 
+		case(io_pin_ll_output_sigma_delta):
+		{
+			if(value < 0)
+				value = 0;
+
+			if(value > gpio_sigma_delta_max)
+				value = gpio_sigma_delta_max;
+
+			sigma_delta_target = value;
+			gpio_sigma_delta_update();
+
+			break;
+		}
+
 		default:
 		{
 			if(error_message)
@@ -831,3 +1597,165 @@ irom app_action_t application_function_pwm_period(const string_t *src, string_t
 
 	return(app_action_normal);
 }
+
+irom app_action_t application_function_gpio_sequence(const string_t *src, string_t *dst)
+{
+	unsigned int step;
+	int mask, duration, repeat;
+
+	if(parse_string(1, src, dst) == parse_ok)
+	{
+		if(string_match(dst, "clear"))
+		{
+			string_clear(dst);
+
+			if(sequence_active)
+				sequence_release();
+
+			sequence_length = 0;
+		}
+		else if(string_match(dst, "add"))
+		{
+			string_clear(dst);
+
+			if((parse_int(2, src, &mask, 0) != parse_ok) || (parse_int(3, src, &duration, 0) != parse_ok))
+			{
+				string_cat(dst, "gpio-sequence add <mask> <duration us>\n");
+				return(app_action_error);
+			}
+
+			if((mask & ~0xffff) || (duration < sequence_min_duration) || ((unsigned int)duration > sequence_max_duration))
+			{
+				string_format(dst, "gpio-sequence: invalid step: mask 0x%x, duration %d us\n", mask, duration);
+				return(app_action_error);
+			}
+
+			if(sequence_length >= sequence_size)
+			{
+				string_format(dst, "gpio-sequence: too many steps (max %d)\n", sequence_size);
+				return(app_action_error);
+			}
+
+			if(sequence_active)
+				sequence_release();
+
+			sequence_table[sequence_length].mask = mask;
+			sequence_table[sequence_length].duration = duration;
+			sequence_length++;
+		}
+		else if(string_match(dst, "start"))
+		{
+			string_clear(dst);
+
+			if(parse_int(2, src, &repeat, 0) != parse_ok)
+				repeat = 0;
+
+			if((repeat < 0) || !sequence_start(dst, repeat))
+				return(app_action_error);
+		}
+		else if(string_match(dst, "stop"))
+		{
+			string_clear(dst);
+
+			if(sequence_active)
+				sequence_release();
+		}
+		else if(string_match(dst, "save"))
+		{
+			string_clear(dst);
+
+			if(sequence_length == 0)
+			{
+				config_delete("gpio.sequence", -1, -1, true);
+			}
+			else if(!config_set_blob("gpio.sequence", -1, -1, sequence_table, sequence_length * sizeof(*sequence_table)) ||
+					!config_set_int("gpio.sequence.length", -1, -1, sequence_length))
+			{
+				string_cat(dst, "> cannot set config\n");
+				return(app_action_error);
+			}
+		}
+		else
+		{
+			string_copy(dst, "gpio-sequence [clear | add <mask> <duration us> | start [<repeat>] | stop | save]\n");
+			return(app_action_error);
+		}
+	}
+
+	string_format(dst, "sequence: %u steps, %s", sequence_length, sequence_running ? "running" : "stopped");
+
+	if(sequence_running && sequence_repeat)
+		string_format(dst, ", %u repeats left", sequence_repeat);
+
+	string_cat(dst, "\n");
+
+	for(step = 0; step < sequence_length; step++)
+		string_format(dst, "%2u: mask 0x%04x, duration %u us\n", step, sequence_table[step].mask, sequence_table[step].duration);
+
+	return(app_action_normal);
+}
+
+irom app_action_t application_function_gpio_sigma_delta(const string_t *src, string_t *dst)
+{
+	int prescale;
+
+	if(parse_int(1, src, &prescale, 0) == parse_ok)
+	{
+		if((prescale < 0) || (prescale > gpio_sigma_delta_max))
+		{
+			string_format(dst, "gpio-sigma-delta: invalid prescale: %d (must be 0-%u)\n", prescale, gpio_sigma_delta_max);
+			return(app_action_error);
+		}
+
+		if(!config_set_int("gpio.sigmadelta.prescale", -1, -1, prescale))
+		{
+			string_cat(dst, "gpio-sigma-delta: cannot set config\n");
+			return(app_action_error);
+		}
+
+		sigma_delta_prescale = prescale;
+		gpio_sigma_delta_update();
+	}
+
+	string_format(dst, "gpio-sigma-delta: prescale: %u, clock: %u kHz, target: %u\n",
+			sigma_delta_prescale, 80000 / (sigma_delta_prescale + 1), sigma_delta_target);
+
+	return(app_action_normal);
+}
+
+irom app_action_t application_function_gpio_fade(const string_t *src, string_t *dst)
+{
+	gpio_data_pin_t *gpio_pin_data;
+	int pin, target, duration;
+
+	if((parse_int(1, src, &pin, 0) != parse_ok) || (parse_int(2, src, &target, 0) != parse_ok))
+	{
+		string_cat(dst, "gpio-fade <pin> <level 0-65535> [<duration ms>]\n");
+		return(app_action_error);
+	}
+
+	if(parse_int(3, src, &duration, 0) != parse_ok)
+		duration = 0;
+
+	if((pin < 0) || (pin >= io_gpio_pin_size) || !gpio_info_table[pin].valid ||
+			(io_config[io_id_gpio][pin].llmode != io_pin_ll_output_analog))
+	{
+		string_format(dst, "gpio-fade: pin %d is not a pwm output\n", pin);
+		return(app_action_error);
+	}
+
+	if((target < 0) || (target > 65535) || (duration < 0) || (duration > 600000))
+	{
+		string_cat(dst, "gpio-fade: level must be 0-65535, duration 0-600000 ms\n");
+		return(app_action_error);
+	}
+
+	gpio_pin_data = &gpio_data[pin];
+
+	pwm_fade_start(pin, target, duration);
+
+	string_format(dst, "gpio-fade: pin %d: level: %u, target: %u, steps: %u\n",
+			pin, gpio_pin_data->pwm.fade_level >> 8, gpio_pin_data->pwm.fade_target, gpio_pin_data->pwm.fade_steps);
+
+	return(app_action_normal);
+}
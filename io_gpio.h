@@ -13,8 +13,12 @@ io_error_t	io_gpio_init_pin_mode(string_t *, const struct io_info_entry_T *, io_
 io_error_t	io_gpio_get_pin_info(string_t *, const struct io_info_entry_T *, io_data_pin_entry_t *, const io_config_pin_entry_t *, int);
 io_error_t	io_gpio_read_pin(string_t *, const struct io_info_entry_T *, io_data_pin_entry_t *, const io_config_pin_entry_t *, int, int *);
 io_error_t	io_gpio_write_pin(string_t *, const struct io_info_entry_T *, io_data_pin_entry_t *, const io_config_pin_entry_t *, int, int);
+bool_t		io_gpio_input_digital(int pin);
 
 app_action_t application_function_pwm_period(const string_t *src, string_t *dst);
+app_action_t application_function_gpio_sequence(const string_t *src, string_t *dst);
+app_action_t application_function_gpio_sigma_delta(const string_t *src, string_t *dst);
+app_action_t application_function_gpio_fade(const string_t *src, string_t *dst);
 
 #include "util.h"
 
@@ -23,7 +27,11 @@ app_action_t application_function_pwm_period(const string_t *src, string_t *dst)
 iram static inline uint32_t gpio_interrupts_enabled(void)
 {
     uint32_t enabled;
+#ifdef __xtensa__
     __asm__ __volatile__("esync; rsr %0,intenable":"=a" (enabled));
+#else
+    enabled = host_intenable();
+#endif
     return enabled;
 }
 
@@ -36,16 +44,12 @@ iram static inline uint32_t gpio_pin_addr(int pin)
 
 iram static inline uint32_t read_peri_reg(uint32_t addr)
 {
-	volatile uint32_t *ptr = (volatile uint32_t *)addr;
-
-	return(*ptr);
+	return(READ_PERI_REG(addr));
 }
 
 iram static inline void write_peri_reg(volatile uint32_t addr, uint32_t value)
 {
-	volatile uint32_t *ptr = (volatile uint32_t *)addr;
-
-	*ptr = value;
+	WRITE_PERI_REG(addr, value);
 }
 
 iram static inline void clear_peri_reg_mask(volatile uint32_t addr, uint32_t mask)
@@ -1,6 +1,9 @@
 #include "io_mcp.h"
+#include "io_gpio.h"
 #include "i2c.h"
 #include "util.h"
+#include "config.h"
+#include "io_debounce.h"
 
 #include <user_interface.h>
 
@@ -9,7 +12,6 @@
 typedef struct
 {
 	uint32_t counter;
-	uint32_t debounce;
 } mcp_data_pin_t;
 
 enum
@@ -39,8 +41,18 @@ enum
 #define GPIO(s)		(_GPIO + s)
 #define OLAT(s)		(_OLAT + s)
 
-static uint8_t pin_output_cache[2];
+enum
+{
+	iocon_mirror = 1 << 6,
+};
+
+// outputs are only written to the shadow registers, both ports are flushed in one transaction later
+
+static uint8_t mcp_output_cache[io_mcp_instance_size][2];
+static bool_t mcp_output_dirty[io_mcp_instance_size];
 static mcp_data_pin_t mcp_data_pin_table[io_mcp_instance_size][16];
+static int mcp_int_pin[io_mcp_instance_size];
+static io_debounce_t mcp_debounce[io_mcp_instance_size];
 
 irom static io_error_t read_register(string_t *error_message, int address, int reg, int *value)
 {
@@ -139,7 +151,9 @@ irom io_error_t io_mcp_init(const struct io_info_entry_T *info)
 	if(i2c_receive(info->address, sizeof(i2cbuffer), i2cbuffer) != i2c_error_ok)
 		return(io_error);
 
-	for(ix = DEFVAL(0); ix < 0x0b; ix++)
+	// IOCON is left out, it may still have the mirror bit set from before a soft reset
+
+	for(ix = DEFVAL(0); ix < IOCON(0); ix++)
 		if(i2cbuffer[ix] != 0x00)
 			return(io_error);
 
@@ -154,67 +168,109 @@ irom io_error_t io_mcp_init(const struct io_info_entry_T *info)
 			mcp_pin_data = &mcp_data_pin_table[instance][pin];
 
 			mcp_pin_data->counter = 0;
-			mcp_pin_data->debounce = 0;
 		}
 	}
 
-	pin_output_cache[0] = 0;
-	pin_output_cache[1] = 0;
+	mcp_output_cache[info->instance][0] = 0;
+	mcp_output_cache[info->instance][1] = 0;
+	mcp_output_dirty[info->instance] = false;
+
+	io_debounce_init(&mcp_debounce[info->instance], (i2cbuffer[GPIO(1)] << 8) | i2cbuffer[GPIO(0)]);
+
+	// optional gpio connected to INTA, with mirroring it reflects both banks
+
+	if(!config_get_int("mcp.%u.int.pin", info->instance, -1, &mcp_int_pin[info->instance]) ||
+			!io_gpio_input_digital(mcp_int_pin[info->instance]))
+		mcp_int_pin[info->instance] = -1;
+
+	if(write_register((string_t *)0, info->address, IOCON(0), (mcp_int_pin[info->instance] >= 0) ? iocon_mirror : 0) != io_ok)
+		return(io_error);
 
 	return(io_ok);
 }
 
+irom static bool_t mcp_interrupt_pending(const struct io_info_entry_T *info)
+{
+	int value;
+
+	// INT output is active low, scan always if it can't be read
+
+	if(mcp_int_pin[info->instance] < 0)
+		return(true);
+
+	if(io_read_pin((string_t *)0, io_id_gpio, mcp_int_pin[info->instance], &value) != io_ok)
+		return(true);
+
+	return(!value);
+}
+
 irom void io_mcp_periodic(int io, const struct io_info_entry_T *info, io_data_entry_t *data, io_flags_t *flags)
 {
 	int pin;
-	int intf[2], intcap[2];
-	int bank, bankpin;
+	uint8_t i2cbuffer[6]; // INTF A/B, INTCAP A/B, GPIO A/B
+	io_debounce_t *debounce = &mcp_debounce[info->instance];
+	uint32_t now, changed, intf, intcap, gpio;
+	bool_t state;
 	mcp_data_pin_t *mcp_pin_data;
 	io_config_pin_entry_t *pin_config;
 
-	read_register((string_t *)0, info->address, INTF(0), &intf[0]);
-	read_register((string_t *)0, info->address, INTF(1), &intf[1]);
+	// only sample when something changed or a pin is still being debounced,
+	// read INTF, INTCAP and GPIO of both ports in one go, using address auto increment,
+	// this also clears the interrupt
+
+	if(!mcp_interrupt_pending(info) && !io_debounce_busy(debounce))
+		return;
+
+	if((i2c_send_1(info->address, INTF(0)) != i2c_error_ok) ||
+			(i2c_receive(info->address, sizeof(i2cbuffer), i2cbuffer) != i2c_error_ok))
+		return;
+
+	intf = (i2cbuffer[1] << 8) | i2cbuffer[0];
+	intcap = (i2cbuffer[3] << 8) | i2cbuffer[2];
+	gpio = (i2cbuffer[5] << 8) | i2cbuffer[4];
+
+	// a pulse that is already over by the time the port is read is still seen in INTCAP
+
+	if(!(changed = io_debounce_sample(debounce, (gpio & ~intf) | (intcap & intf))))
+		return;
 
-	read_register((string_t *)0, info->address, INTCAP(0), &intcap[0]);
-	read_register((string_t *)0, info->address, INTCAP(1), &intcap[1]);
+	now = system_get_time();
 
 	for(pin = 0; pin < 16; pin++)
 	{
-		bank = (pin & 0x08) >> 3;
-		bankpin = pin & 0x07;
+		if(!(changed & (1 << pin)))
+			continue;
 
 		mcp_pin_data = &mcp_data_pin_table[info->instance][pin];
 		pin_config = &io_config[io][pin];
+		state = !!(debounce->state & (1 << pin));
 
-		if(pin_config->llmode == io_pin_ll_counter)
+		if(pin_config->llmode == io_pin_ll_input_digital)
+			io_event_add(io, pin, state, now);
+
+		if((pin_config->llmode == io_pin_ll_counter) && io_debounce_counts(pin_config, state))
 		{
-			if(mcp_pin_data->debounce != 0)
-			{
-				if(mcp_pin_data->debounce >= 10)
-					mcp_pin_data->debounce -= 10; // 10 ms per tick
-				else
-					mcp_pin_data->debounce = 0;
-			}
-			else
-			{
-				if((intf[bank] & (1 << bankpin)) && !(intcap[bank] & (1 << bankpin))) // only count downward edge, counter is mostly pull-up
-				{
-					mcp_pin_data->counter++;
-					mcp_pin_data->debounce = pin_config->speed;
-					flags->counter_triggered = 1;
-				}
-			}
+			mcp_pin_data->counter++;
+			flags->counter_triggered = 1;
+			io_event_add(io, pin, mcp_pin_data->counter, now);
 		}
 	}
 }
 
 irom io_error_t io_mcp_init_pin_mode(string_t *error_message, const struct io_info_entry_T *info, io_data_pin_entry_t *pin_data, const io_config_pin_entry_t *pin_config, int pin)
 {
-	int bank, bankpin;
+	int bank, bankpin, tv;
 
 	bank = (pin & 0x08) >> 3;
 	bankpin = pin & 0x07;
 
+	// make sure the latches are up to date before they're modified below
+
+	if(io_mcp_flush(error_message, info) != io_ok)
+		return(io_error);
+
+	mcp_output_cache[info->instance][bank] &= ~(1 << bankpin);
+
 	if(clear_set_register(error_message, info->address, IPOL(bank), 1 << bankpin, 0) != io_ok) // polarity inversion = 0
 		return(io_error);
 
@@ -252,9 +308,14 @@ irom io_error_t io_mcp_init_pin_mode(string_t *error_message, const struct io_in
 			if(pin_config->flags.pullup && (clear_set_register(error_message, info->address, GPPU(bank), 0, 1 << bankpin) != io_ok))
 				return(io_error);
 
-			if((pin_config->llmode == io_pin_ll_counter) && (clear_set_register(error_message, info->address, GPINTEN(bank), 0, 1 << bankpin) != io_ok)) // pc int enable = 1
+			if(clear_set_register(error_message, info->address, GPINTEN(bank), 0, 1 << bankpin) != io_ok) // pc int enable = 1
 				return(io_error);
 
+			if(read_register(error_message, info->address, GPIO(bank), &tv) != io_ok)
+				return(io_error);
+
+			io_debounce_pin(&mcp_debounce[info->instance], pin, io_debounce_samples(pin_config), !!(tv & (1 << bankpin)));
+
 			break;
 		}
 
@@ -306,7 +367,8 @@ irom io_error_t io_mcp_get_pin_info(string_t *dst, const struct io_info_entry_T
 			if(read_register(dst, info->address, GPIO(bank), &tv) != io_ok)
 				return(io_error);
 
-			string_format(dst, "current io: %s, debounce: %d", onoff(tv & (1 << bankpin)), mcp_pin_data->debounce);
+			string_format(dst, "current io: %s, counter: %u, debounce: %d ms, samples: %d", onoff(tv & (1 << bankpin)),
+					mcp_pin_data->counter, pin_config->speed, io_debounce_samples(pin_config));
 
 			break;
 		}
@@ -322,7 +384,7 @@ irom io_error_t io_mcp_get_pin_info(string_t *dst, const struct io_info_entry_T
 				return(io_error);
 
 			olat = tv & (1 << bankpin);
-			cached = pin_output_cache[bank] & (1 << bankpin);
+			cached = mcp_output_cache[info->instance][bank] & (1 << bankpin);
 
 			string_format(dst, "current latch: %s, io: %s, cache: %s", onoff(io), onoff(olat), onoff(cached));
 
@@ -350,7 +412,6 @@ irom io_error_t io_mcp_read_pin(string_t *error_message, const struct io_info_en
 	switch(pin_config->llmode)
 	{
 		case(io_pin_ll_input_digital):
-		case(io_pin_ll_output_digital):
 		{
 			if(read_register(error_message, info->address, GPIO(bank), &tv) != io_ok)
 				return(io_error);
@@ -360,6 +421,13 @@ irom io_error_t io_mcp_read_pin(string_t *error_message, const struct io_info_en
 			break;
 		}
 
+		case(io_pin_ll_output_digital):
+		{
+			*value = !!(mcp_output_cache[info->instance][bank] & (1 << bankpin));
+
+			break;
+		}
+
 		case(io_pin_ll_counter):
 		{
 			*value = mcp_pin_data->counter;
@@ -389,17 +457,16 @@ irom io_error_t io_mcp_write_pin(string_t *error_message, const struct io_info_e
 
 	mcp_pin_data = &mcp_data_pin_table[info->instance][pin];
 
-	if(value)
-		pin_output_cache[bank] |= 1 << bankpin;
-	else
-		pin_output_cache[bank] &= ~(1 << bankpin);
-
 	switch(pin_config->llmode)
 	{
 		case(io_pin_ll_output_digital):
 		{
-			if(write_register(error_message, info->address, GPIO(bank), pin_output_cache[bank]) != io_ok)
-				return(io_error);
+			if(value)
+				mcp_output_cache[info->instance][bank] |= 1 << bankpin;
+			else
+				mcp_output_cache[info->instance][bank] &= ~(1 << bankpin);
+
+			mcp_output_dirty[info->instance] = true;
 
 			break;
 		}
@@ -422,3 +489,30 @@ irom io_error_t io_mcp_write_pin(string_t *error_message, const struct io_info_e
 
 	return(io_ok);
 }
+
+irom io_error_t io_mcp_flush(string_t *error_message, const struct io_info_entry_T *info)
+{
+	uint8_t i2cbuffer[3];
+	i2c_error_t error;
+
+	if(!mcp_output_dirty[info->instance])
+		return(io_ok);
+
+	// OLAT A and B in one go, using address auto increment
+
+	i2cbuffer[0] = OLAT(0);
+	i2cbuffer[1] = mcp_output_cache[info->instance][0];
+	i2cbuffer[2] = mcp_output_cache[info->instance][1];
+
+	if((error = i2c_send(info->address, sizeof(i2cbuffer), i2cbuffer)) != i2c_error_ok)
+	{
+		if(error_message)
+			i2c_error_format_string(error_message, error);
+
+		return(io_error);
+	}
+
+	mcp_output_dirty[info->instance] = false;
+
+	return(io_ok);
+}
@@ -18,5 +18,6 @@ io_error_t	io_mcp_init_pin_mode(string_t *, const struct io_info_entry_T *, io_d
 io_error_t	io_mcp_get_pin_info(string_t *, const struct io_info_entry_T *, io_data_pin_entry_t *, const io_config_pin_entry_t *, int);
 io_error_t	io_mcp_read_pin(string_t *, const struct io_info_entry_T *, io_data_pin_entry_t *, const io_config_pin_entry_t *, int, int *);
 io_error_t	io_mcp_write_pin(string_t *, const struct io_info_entry_T *, io_data_pin_entry_t *, const io_config_pin_entry_t *, int, int);
+io_error_t	io_mcp_flush(string_t *, const struct io_info_entry_T *);
 
 #endif
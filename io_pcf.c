@@ -1,53 +1,110 @@
 #include "io_pcf.h"
 #include "i2c.h"
 #include "util.h"
+#include "io_debounce.h"
 
 #include <user_interface.h>
 
 #include <stdlib.h>
 
+// the pcf8574 has quasi-bidirectional pins, a pin can only be used as input when it's set high
+
+// outputs are only written to the shadow register, it's flushed in one transaction later
+
 static uint8 pcf_data_pin_table[io_pcf_instance_size];
+static bool_t pcf_output_dirty[io_pcf_instance_size];
+static uint32_t pcf_counter_table[io_pcf_instance_size][8];
+static io_debounce_t pcf_debounce[io_pcf_instance_size];
+static uint8_t pcf_input_mask[io_pcf_instance_size];
 
 irom io_error_t io_pcf_init(const struct io_info_entry_T *info)
 {
 	uint8_t i2cbuffer[1];
+	int pin;
+
+	pcf_data_pin_table[info->instance] = 0xff;
+	pcf_output_dirty[info->instance] = false;
+	pcf_input_mask[info->instance] = 0;
 
-	pcf_data_pin_table[info->instance] = 0x00;
+	for(pin = 0; pin < 8; pin++)
+		pcf_counter_table[info->instance][pin] = 0;
 
 	if(i2c_receive(info->address, 1, i2cbuffer) != i2c_error_ok)
 		return(io_error);
 
+	io_debounce_init(&pcf_debounce[info->instance], i2cbuffer[0]);
+
 	return(io_ok);
 }
 
+irom void io_pcf_periodic(int io, const struct io_info_entry_T *info, io_data_entry_t *data, io_flags_t *flags)
+{
+	uint8_t i2cbuffer[1];
+	io_debounce_t *debounce = &pcf_debounce[info->instance];
+	io_config_pin_entry_t *pin_config;
+	uint32_t now, changed;
+	bool_t state;
+	int pin;
+
+	// nothing to sample when no pin is an input or counter
+
+	if(!pcf_input_mask[info->instance])
+		return;
+
+	if(i2c_receive(info->address, 1, i2cbuffer) != i2c_error_ok)
+		return;
+
+	if(!(changed = io_debounce_sample(debounce, i2cbuffer[0])))
+		return;
+
+	now = system_get_time();
+
+	for(pin = 0; pin < 8; pin++)
+	{
+		if(!(changed & (1 << pin)))
+			continue;
+
+		pin_config = &io_config[io][pin];
+		state = !!(debounce->state & (1 << pin));
+
+		if(pin_config->llmode == io_pin_ll_input_digital)
+			io_event_add(io, pin, state, now);
+
+		if((pin_config->llmode == io_pin_ll_counter) && io_debounce_counts(pin_config, state))
+		{
+			pcf_counter_table[info->instance][pin]++;
+			flags->counter_triggered = 1;
+			io_event_add(io, pin, pcf_counter_table[info->instance][pin], now);
+		}
+	}
+}
+
 irom io_error_t io_pcf_init_pin_mode(string_t *error_message, const struct io_info_entry_T *info, io_data_pin_entry_t *pin_data, const io_config_pin_entry_t *pin_config, int pin)
 {
 	uint8_t *pcf_pin_data = &pcf_data_pin_table[info->instance];
+	uint8_t i2cbuffer[1];
 	i2c_error_t error;
 
+	pcf_input_mask[info->instance] &= ~(1 << pin);
+
 	switch(pin_config->llmode)
 	{
 		case(io_pin_ll_disabled):
 		case(io_pin_ll_input_digital):
+		case(io_pin_ll_counter):
 		{
-			if((error = i2c_send_1(info->address, 0xff)) != i2c_error_ok)
-			{
-				if(error_message)
-					i2c_error_format_string(error_message, error);
-				return(io_error);
-			}
+			*pcf_pin_data |= 1 << pin;
+			pcf_counter_table[info->instance][pin] = 0;
+
+			if(pin_config->llmode != io_pin_ll_disabled)
+				pcf_input_mask[info->instance] |= 1 << pin;
 
 			break;
 		}
 
 		case(io_pin_ll_output_digital):
 		{
-			if((error = i2c_send_1(info->address, 0x00)) != i2c_error_ok)
-			{
-				if(error_message)
-					i2c_error_format_string(error_message, error);
-				return(io_error);
-			}
+			*pcf_pin_data &= ~(1 << pin);
 
 			break;
 		}
@@ -61,7 +118,17 @@ irom io_error_t io_pcf_init_pin_mode(string_t *error_message, const struct io_in
 		}
 	}
 
-	*pcf_pin_data = *pcf_pin_data & ~(1 << pin);
+	if(((error = i2c_send_1(info->address, *pcf_pin_data)) != i2c_error_ok) ||
+			((error = i2c_receive(info->address, 1, i2cbuffer)) != i2c_error_ok))
+	{
+		if(error_message)
+			i2c_error_format_string(error_message, error);
+		return(io_error);
+	}
+
+	pcf_output_dirty[info->instance] = false;
+
+	io_debounce_pin(&pcf_debounce[info->instance], pin, io_debounce_samples(pin_config), !!(i2cbuffer[0] & (1 << pin)));
 
 	return(io_ok);
 }
@@ -74,7 +141,6 @@ irom io_error_t io_pcf_read_pin(string_t *error_message, const struct io_info_en
 	switch(pin_config->llmode)
 	{
 		case(io_pin_ll_input_digital):
-		case(io_pin_ll_output_digital):
 		{
 			if((error = i2c_receive(info->address, 1, i2c_data)) != i2c_error_ok)
 			{
@@ -82,6 +148,22 @@ irom io_error_t io_pcf_read_pin(string_t *error_message, const struct io_info_en
 				return(io_error);
 			}
 
+			*value = !!(i2c_data[0] & (1 << pin));
+
+			break;
+		}
+
+		case(io_pin_ll_output_digital):
+		{
+			*value = !!(pcf_data_pin_table[info->instance] & (1 << pin));
+
+			break;
+		}
+
+		case(io_pin_ll_counter):
+		{
+			*value = pcf_counter_table[info->instance][pin];
+
 			break;
 		}
 
@@ -94,14 +176,11 @@ irom io_error_t io_pcf_read_pin(string_t *error_message, const struct io_info_en
 		}
 	}
 
-	*value = !!(i2c_data[0] & (1 << pin));
-
 	return(io_ok);
 }
 
 irom io_error_t io_pcf_write_pin(string_t *error_message, const struct io_info_entry_T *info, io_data_pin_entry_t *pin_data, const io_config_pin_entry_t *pin_config, int pin, int value)
 {
-	i2c_error_t error;
 	uint8_t *pcf_pin_data = &pcf_data_pin_table[info->instance];
 
 	switch(pin_config->llmode)
@@ -112,12 +191,15 @@ irom io_error_t io_pcf_write_pin(string_t *error_message, const struct io_info_e
 				*pcf_pin_data = *pcf_pin_data |  (1 << pin);
 			else
 				*pcf_pin_data = *pcf_pin_data & ~(1 << pin);
-			
-			if((error = i2c_send_1(info->address, *pcf_pin_data)) != i2c_error_ok)
-			{
-				i2c_error_format_string(error_message, error);
-				return(io_error);
-			}
+
+			pcf_output_dirty[info->instance] = true;
+
+			break;
+		}
+
+		case(io_pin_ll_counter):
+		{
+			pcf_counter_table[info->instance][pin] = value;
 
 			break;
 		}
@@ -133,3 +215,23 @@ irom io_error_t io_pcf_write_pin(string_t *error_message, const struct io_info_e
 
 	return(io_ok);
 }
+
+irom io_error_t io_pcf_flush(string_t *error_message, const struct io_info_entry_T *info)
+{
+	i2c_error_t error;
+
+	if(!pcf_output_dirty[info->instance])
+		return(io_ok);
+
+	if((error = i2c_send_1(info->address, pcf_data_pin_table[info->instance])) != i2c_error_ok)
+	{
+		if(error_message)
+			i2c_error_format_string(error_message, error);
+
+		return(io_error);
+	}
+
+	pcf_output_dirty[info->instance] = false;
+
+	return(io_ok);
+}
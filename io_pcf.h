@@ -13,8 +13,10 @@ typedef enum
 } io_pcf_instance_t;
 
 io_error_t	io_pcf_init(const struct io_info_entry_T *);
+void		io_pcf_periodic(int io, const struct io_info_entry_T *, io_data_entry_t *, io_flags_t *);
 io_error_t	io_pcf_init_pin_mode(string_t *, const struct io_info_entry_T *, io_data_pin_entry_t *, const io_config_pin_entry_t *, int);
 io_error_t	io_pcf_read_pin(string_t *, const struct io_info_entry_T *, io_data_pin_entry_t *, const io_config_pin_entry_t *, int, int *);
 io_error_t	io_pcf_write_pin(string_t *, const struct io_info_entry_T *, io_data_pin_entry_t *, const io_config_pin_entry_t *, int, int);
+io_error_t	io_pcf_flush(string_t *, const struct io_info_entry_T *);
 
 #endif
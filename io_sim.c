@@ -0,0 +1,259 @@
+#include "io_sim.h"
+#include "util.h"
+#include "config.h"
+#include "io_debounce.h"
+
+#include <user_interface.h>
+
+#include <stdlib.h>
+
+// simulated io, the pins only exist in ram and the inputs are driven with io-sim-input,
+// to try out timers, triggers, counters and analog ramps without any hardware attached,
+// it's only detected when enabled with config "sim.enable", its slots in io_config and io_data
+// and the state below take ram in every build though
+
+static uint32_t sim_inputs;
+static uint32_t sim_outputs;
+static uint32_t sim_counter[io_sim_pins];
+static unsigned int sim_analog[io_sim_pins];
+static io_debounce_t sim_debounce;
+
+irom io_error_t io_sim_init(const struct io_info_entry_T *info)
+{
+	int enable, pin;
+
+	if(!config_get_int("sim.enable", -1, -1, &enable) || !enable)
+		return(io_error);
+
+	sim_inputs = 0;
+	sim_outputs = 0;
+
+	for(pin = 0; pin < io_sim_pins; pin++)
+	{
+		sim_counter[pin] = 0;
+		sim_analog[pin] = 0;
+	}
+
+	io_debounce_init(&sim_debounce, sim_inputs);
+
+	return(io_ok);
+}
+
+irom void io_sim_periodic(int io, const struct io_info_entry_T *info, io_data_entry_t *data, io_flags_t *flags)
+{
+	io_config_pin_entry_t *pin_config;
+	uint32_t now, changed;
+	bool_t state;
+	int pin;
+
+	if(!(changed = io_debounce_sample(&sim_debounce, sim_inputs)))
+		return;
+
+	now = system_get_time();
+
+	for(pin = 0; pin < io_sim_pins; pin++)
+	{
+		if(!(changed & (1 << pin)))
+			continue;
+
+		pin_config = &io_config[io][pin];
+		state = !!(sim_debounce.state & (1 << pin));
+
+		if(pin_config->llmode == io_pin_ll_input_digital)
+			io_event_add(io, pin, state, now);
+
+		if((pin_config->llmode == io_pin_ll_counter) && io_debounce_counts(pin_config, state))
+		{
+			sim_counter[pin]++;
+			flags->counter_triggered = 1;
+			io_event_add(io, pin, sim_counter[pin], now);
+		}
+	}
+}
+
+irom io_error_t io_sim_init_pin_mode(string_t *error_message, const struct io_info_entry_T *info, io_data_pin_entry_t *pin_data, const io_config_pin_entry_t *pin_config, int pin)
+{
+	switch(pin_config->llmode)
+	{
+		case(io_pin_ll_disabled):
+		case(io_pin_ll_input_digital):
+		case(io_pin_ll_counter):
+		{
+			sim_counter[pin] = 0;
+			io_debounce_pin(&sim_debounce, pin, io_debounce_samples(pin_config), !!(sim_inputs & (1 << pin)));
+
+			break;
+		}
+
+		case(io_pin_ll_output_digital):
+		{
+			sim_outputs &= ~(1 << pin);
+
+			break;
+		}
+
+		case(io_pin_ll_output_analog):
+		{
+			sim_analog[pin] = 0;
+
+			break;
+		}
+
+		default:
+		{
+			if(error_message)
+				string_cat(error_message, "invalid mode for this pin\n");
+
+			return(io_error);
+		}
+	}
+
+	return(io_ok);
+}
+
+irom io_error_t io_sim_get_pin_info(string_t *dst, const struct io_info_entry_T *info, io_data_pin_entry_t *pin_data, const io_config_pin_entry_t *pin_config, int pin)
+{
+	switch(pin_config->llmode)
+	{
+		case(io_pin_ll_input_digital):
+		case(io_pin_ll_counter):
+		{
+			string_format(dst, "simulated input: %s, debounced: %s", onoff(sim_inputs & (1 << pin)), onoff(sim_debounce.state & (1 << pin)));
+
+			break;
+		}
+
+		case(io_pin_ll_output_digital):
+		{
+			string_format(dst, "simulated output: %s", onoff(sim_outputs & (1 << pin)));
+
+			break;
+		}
+
+		case(io_pin_ll_output_analog):
+		{
+			string_format(dst, "simulated analog output: %u", sim_analog[pin]);
+
+			break;
+		}
+
+		default:
+		{
+		}
+	}
+
+	return(io_ok);
+}
+
+irom io_error_t io_sim_read_pin(string_t *error_message, const struct io_info_entry_T *info, io_data_pin_entry_t *pin_data, const io_config_pin_entry_t *pin_config, int pin, int *value)
+{
+	switch(pin_config->llmode)
+	{
+		case(io_pin_ll_input_digital):
+		{
+			*value = !!(sim_debounce.state & (1 << pin));
+
+			break;
+		}
+
+		case(io_pin_ll_output_digital):
+		{
+			*value = !!(sim_outputs & (1 << pin));
+
+			break;
+		}
+
+		case(io_pin_ll_counter):
+		{
+			*value = sim_counter[pin];
+
+			break;
+		}
+
+		case(io_pin_ll_output_analog):
+		{
+			*value = sim_analog[pin];
+
+			break;
+		}
+
+		default:
+		{
+			if(error_message)
+				string_cat(error_message, "invalid mode for this pin\n");
+
+			return(io_error);
+		}
+	}
+
+	return(io_ok);
+}
+
+irom io_error_t io_sim_write_pin(string_t *error_message, const struct io_info_entry_T *info, io_data_pin_entry_t *pin_data, const io_config_pin_entry_t *pin_config, int pin, int value)
+{
+	switch(pin_config->llmode)
+	{
+		case(io_pin_ll_output_digital):
+		{
+			if(value)
+				sim_outputs |= 1 << pin;
+			else
+				sim_outputs &= ~(1 << pin);
+
+			break;
+		}
+
+		case(io_pin_ll_counter):
+		{
+			sim_counter[pin] = value;
+
+			break;
+		}
+
+		case(io_pin_ll_output_analog):
+		{
+			if(value < 0)
+				value = 0;
+
+			sim_analog[pin] = value;
+
+			break;
+		}
+
+		default:
+		{
+			if(error_message)
+				string_cat(error_message, "invalid mode for this pin\n");
+
+			return(io_error);
+		}
+	}
+
+	return(io_ok);
+}
+
+irom app_action_t application_function_io_sim_input(const string_t *src, string_t *dst)
+{
+	int pin, value;
+
+	if((parse_int(1, src, &pin, 0) != parse_ok) || (parse_int(2, src, &value, 0) != parse_ok))
+	{
+		string_cat(dst, "io-sim-input <pin> <0|1>\n");
+		return(app_action_error);
+	}
+
+	if((pin < 0) || (pin >= io_sim_pins))
+	{
+		string_cat(dst, "invalid pin\n");
+		return(app_action_error);
+	}
+
+	if(value)
+		sim_inputs |= 1 << pin;
+	else
+		sim_inputs &= ~(1 << pin);
+
+	string_format(dst, "io-sim-input: pin %d: %s\n", pin, onoff(value));
+
+	return(app_action_normal);
+}
@@ -0,0 +1,23 @@
+#ifndef io_sim_h
+#define io_sim_h
+
+#include "io.h"
+#include "util.h"
+
+#include <stdint.h>
+
+enum
+{
+	io_sim_pins = 16,
+};
+
+io_error_t	io_sim_init(const struct io_info_entry_T *);
+void		io_sim_periodic(int io, const struct io_info_entry_T *, io_data_entry_t *, io_flags_t *);
+io_error_t	io_sim_init_pin_mode(string_t *, const struct io_info_entry_T *, io_data_pin_entry_t *, const io_config_pin_entry_t *, int);
+io_error_t	io_sim_get_pin_info(string_t *, const struct io_info_entry_T *, io_data_pin_entry_t *, const io_config_pin_entry_t *, int);
+io_error_t	io_sim_read_pin(string_t *, const struct io_info_entry_T *, io_data_pin_entry_t *, const io_config_pin_entry_t *, int, int *);
+io_error_t	io_sim_write_pin(string_t *, const struct io_info_entry_T *, io_data_pin_entry_t *, const io_config_pin_entry_t *, int, int);
+
+app_action_t application_function_io_sim_input(const string_t *src, string_t *dst);
+
+#endif
@@ -44,7 +44,6 @@ irom app_action_t application_function_ota_read(const string_t *src, string_t *d
 	ota_state = ota_reading;
 	data_transferred = 0;
 
-	string_crc32_init();
 	MD5Init(&md5);
 
 	string_cat(dst, "READ\n");
@@ -152,7 +151,6 @@ irom app_action_t application_function_ota_write(const string_t *src, string_t *
 	flash_sector = flash_start_address / 0x1000;
 
 	string_clear(&buffer_4k);
-	string_crc32_init();
 	MD5Init(&md5);
 
 	string_format(dst, "WRITE %d %u\n", flash_slot, flash_sector);
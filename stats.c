@@ -18,11 +18,17 @@ int stat_fast_timer;
 int stat_slow_timer;
 int stat_timer_interrupts;
 int stat_pwm_timer_interrupts;
+int stat_sequence_timer_interrupts;
+int stat_pwm_phase_builds;
+int stat_gpio_interrupts;
+int stat_io_deferred_overrun;
+int stat_io_deferred_budget;
 int stat_i2c_init_time_us;
 int stat_display_init_time_us;
 
 int stat_update_uart;
 int stat_update_longop;
+int stat_update_io;
 int stat_update_command;
 int stat_update_display;
 int stat_update_ntp;
@@ -120,8 +126,14 @@ irom void stats_generate(string_t *dst)
 			"> fast timer fired: %u\n"
 			"> slow timer fired: %u\n"
 			"> pwm timer int fired: %u\n"
+			"> sequence timer int fired: %u\n"
+			"> pwm phase sets built: %u\n"
+			"> gpio int fired: %u\n"
 			"> uart updated: %u\n"
 			"> longops processed: %u\n"
+			"> io deferred processed: %u\n"
+			"> io deferred overrun: %u\n"
+			"> io deferred out of budget: %u\n"
 			"> commands processed: %u\n"
 			"> display updated: %u\n"
 			"> ntp updated: %u\n"
@@ -158,8 +170,14 @@ irom void stats_generate(string_t *dst)
 			stat_fast_timer,
 			stat_slow_timer,
 			stat_pwm_timer_interrupts,
+			stat_sequence_timer_interrupts,
+			stat_pwm_phase_builds,
+			stat_gpio_interrupts,
 			stat_update_uart,
 			stat_update_longop,
+			stat_update_io,
+			stat_io_deferred_overrun,
+			stat_io_deferred_budget,
 			stat_update_command,
 			stat_update_display,
 			stat_update_ntp,
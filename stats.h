@@ -10,11 +10,17 @@ extern int stat_uart_tx_interrupts;
 extern int stat_fast_timer;
 extern int stat_slow_timer;
 extern int stat_pwm_timer_interrupts;
+extern int stat_sequence_timer_interrupts;
+extern int stat_pwm_phase_builds;
+extern int stat_gpio_interrupts;
+extern int stat_io_deferred_overrun;
+extern int stat_io_deferred_budget;
 extern int stat_i2c_init_time_us;
 extern int stat_display_init_time_us;
 
 extern int stat_update_uart;
 extern int stat_update_longop;
+extern int stat_update_io;
 extern int stat_update_command;
 extern int stat_update_display;
 extern int stat_update_ntp;
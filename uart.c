@@ -92,7 +92,7 @@ iram static void uart_callback(void *p)
 				queue_push(&data_receive_queue, data);
 		}
 
-		system_os_post(background_task_id, 0, 0);
+		system_os_post(background_task_id, background_task_default, 0);
 	}
 
 	// receive transmit fifo "empty", room for new data in the fifo
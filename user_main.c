@@ -90,7 +90,7 @@ irom static void tcp_data_sent_callback(void *arg)
 
 	// retry to send data still in the fifo
 
-	system_os_post(background_task_id, 0, 0);
+	system_os_post(background_task_id, background_task_default, 0);
 }
 
 irom static void tcp_data_receive_callback(void *arg, char *buffer, unsigned short length)
@@ -195,7 +195,7 @@ irom static void tcp_cmd_receive_callback(void *arg, char *buffer, unsigned shor
 	string_set(&cmd.receive_buffer, buffer, length, length);
 	cmd.receive_ready = true;
 
-	system_os_post(background_task_id, 0, 0);
+	system_os_post(background_task_id, background_task_default, 0);
 }
 
 irom static void tcp_cmd_reconnect_callback(void *arg, int8_t err)
@@ -347,6 +347,18 @@ irom static bool_t background_task_command_handler(void)
 
 irom static void background_task(os_event_t *events) // posted every ~100 ms = ~10 Hz
 {
+	// deferred io processing, posted from the fast timer, doesn't count as a background run
+
+	if(events->sig == background_task_io_periodic)
+	{
+		stat_update_io++;
+
+		if(io_periodic_deferred())
+			system_os_post(background_task_id, background_task_io_periodic, 0);
+
+		return;
+	}
+
 	stat_slow_timer++;
 	config_wlan_mode_t wlan_mode;
 	int wlan_mode_int;
@@ -354,28 +366,28 @@ irom static void background_task(os_event_t *events) // posted every ~100 ms = ~
 	if(background_task_update_uart())
 	{
 		stat_update_uart++;
-		system_os_post(background_task_id, 0, 0);
+		system_os_post(background_task_id, background_task_default, 0);
 		return;
 	}
 
 	if(background_task_longop_handler())
 	{
 		stat_update_longop++;
-		system_os_post(background_task_id, 0, 0);
+		system_os_post(background_task_id, background_task_default, 0);
 		return;
 	}
 
 	if(background_task_command_handler())
 	{
 		stat_update_command++;
-		system_os_post(background_task_id, 0, 0);
+		system_os_post(background_task_id, background_task_default, 0);
 		return;
 	}
 
 	if(display_periodic())
 	{
 		stat_update_display++;
-		system_os_post(background_task_id, 0, 0);
+		system_os_post(background_task_id, background_task_default, 0);
 		return;
 	}
 
@@ -406,9 +418,10 @@ iram static void fast_timer_callback(void *arg)
 
 	stat_fast_timer++;
 
-	// timer runs every 10 ms = 100 Hz
+	// timer runs every 10 ms = 100 Hz, slow io processing is deferred to the background task
 
-	io_periodic();
+	if(io_periodic_fast())
+		system_os_post(background_task_id, background_task_io_periodic, 0);
 }
 
 irom static void slow_timer_callback(void *arg)
@@ -419,7 +432,7 @@ irom static void slow_timer_callback(void *arg)
 
 	time_periodic();
 
-	system_os_post(background_task_id, 0, 0);
+	system_os_post(background_task_id, background_task_default, 0);
 }
 
 uint32_t user_rf_cal_sector_set(void);
@@ -440,6 +453,8 @@ irom void user_init(void)
 	int uart_baud, uart_data, uart_stop, uart_parity_int;
 	uart_parity_t uart_parity;
 
+	system_timer_reinit(); // enable us resolution timers, must be called first
+
 	queue_new(&data_send_queue, sizeof(data_send_queue_buffer), data_send_queue_buffer);
 	queue_new(&data_receive_queue, sizeof(data_receive_queue_buffer), data_receive_queue_buffer);
 
@@ -484,9 +499,10 @@ irom static void wlan_event_handler(System_Event_t *event)
 {
 	int trigger_io, trigger_pin;
 
-	if(config_get_int("trigger.assoc.io", -1, -1, &trigger_io) &&
-			config_get_int("trigger.assoc.pin", -1, -1, &trigger_pin) &&
-			(trigger_io >= 0) && (trigger_pin >= 0))
+	trigger_io = config_runtime_get()->trigger_assoc_io;
+	trigger_pin = config_runtime_get()->trigger_assoc_pin;
+
+	if((trigger_io >= 0) && (trigger_pin >= 0))
 	{
 		switch(event->event)
 		{
@@ -14,6 +14,12 @@ enum
 	background_task_queue_length	= 64,
 };
 
+enum
+{
+	background_task_default			= 0,
+	background_task_io_periodic		= 1,
+};
+
 extern queue_t data_send_queue;
 extern queue_t data_receive_queue;
 extern os_event_t background_task_queue[background_task_queue_length];
@@ -76,34 +76,173 @@ irom attr_pure const char *string_to_const_ptr(const string_t *string)
 	return(string->buffer);
 }
 
-irom void string_format_ptr(string_t *dst, const char *fmt_flash, ...)
+// flash only allows aligned 32 bit reads, this works for both flash and ram
+
+static always_inline char flash_char(const char *ptr)
 {
-	va_list ap;
+	const uint32_t *word = (const uint32_t *)(const void *)((uintptr_t)ptr & ~(uintptr_t)3);
 
-	copy_flash_to_ram(dram_buffer, fmt_flash, sizeof(dram_buffer));
+	return((char)((*word >> (((uintptr_t)ptr & 3) << 3)) & 0xff));
+}
 
-	va_start(ap, fmt_flash);
-	dst->length += ets_vsnprintf(dst->buffer + dst->length, dst->size - dst->length - 1, dram_buffer, ap);
-	va_end(ap);
+irom static void string_format_field(string_t *dst, const char *src, int length, int width, bool_t left, char pad)
+{
+	int current;
 
-	if(dst->length > (dst->size - 1))
-		dst->length = dst->size - 1;
+	if(!left)
+		for(; width > length; width--)
+			if(string_space(dst))
+				dst->buffer[dst->length++] = pad;
+
+	for(current = 0; current < length; current++)
+		if(string_space(dst))
+			dst->buffer[dst->length++] = flash_char(src + current);
+
+	for(; width > length; width--)
+		if(string_space(dst))
+			dst->buffer[dst->length++] = ' ';
+}
+
+// subset of printf, flags "-" and "0", width and conversions %s %c %d %u %x %X and %%
+
+irom static void string_vformat(string_t *dst, const char *fmt, va_list ap)
+{
+	char current, pad, digits[12];
+	static roflash const char hex_lower[] = "0123456789abcdef";
+	static roflash const char hex_upper[] = "0123456789ABCDEF";
+	const char *src, *hex;
+	char *digit;
+	unsigned int value, base, width;
+	bool_t left, negative;
+
+	while((current = flash_char(fmt++)))
+	{
+		if(current != '%')
+		{
+			if(string_space(dst))
+				dst->buffer[dst->length++] = current;
+
+			continue;
+		}
+
+		left = false;
+		pad = ' ';
+		width = 0;
+
+		if((current = flash_char(fmt++)) == '-')
+		{
+			left = true;
+			current = flash_char(fmt++);
+		}
+
+		if(current == '0')
+		{
+			pad = '0';
+			current = flash_char(fmt++);
+		}
+
+		for(; (current >= '0') && (current <= '9'); current = flash_char(fmt++))
+			width = (width * 10) + (current - '0');
+
+		while(current == 'l')
+			current = flash_char(fmt++);
+
+		switch(current)
+		{
+			case('\0'):
+			{
+				goto done;
+			}
+
+			case('s'):
+			{
+				src = va_arg(ap, const char *);
+
+				for(value = 0; flash_char(src + value); value++)
+					;
+
+				string_format_field(dst, src, value, width, left, ' ');
+
+				break;
+			}
+
+			case('c'):
+			{
+				digits[0] = (char)va_arg(ap, int);
+				string_format_field(dst, digits, 1, width, left, ' ');
+
+				break;
+			}
+
+			case('d'):
+			case('u'):
+			case('x'):
+			case('X'):
+			{
+				value = va_arg(ap, unsigned int);
+				base = ((current == 'x') || (current == 'X')) ? 16 : 10;
+				hex = (current == 'X') ? hex_upper : hex_lower;
+
+				if((negative = ((current == 'd') && ((int)value < 0))))
+					value = -value;
+
+				digit = digits + sizeof(digits);
+
+				do
+				{
+					*--digit = flash_char(hex + (value % base));
+					value /= base;
+				} while(value);
+
+				if(negative)
+				{
+					if((pad == '0') && !left)
+					{
+						if(string_space(dst))
+							dst->buffer[dst->length++] = '-';
+
+						if(width > 0)
+							width--;
+					}
+					else
+						*--digit = '-';
+				}
+
+				string_format_field(dst, digit, (digits + sizeof(digits)) - digit, width, left, pad);
+
+				break;
+			}
+
+			default:
+			{
+				if(string_space(dst))
+					dst->buffer[dst->length++] = current;
+
+				break;
+			}
+		}
+	}
 
+done:
 	dst->buffer[dst->length] = '\0';
 }
 
-irom void string_format_data(string_t *dst, const char *fmt, ...)
+irom void string_format_ptr(string_t *dst, const char *fmt_flash, ...)
 {
 	va_list ap;
 
-	va_start(ap, fmt);
-	dst->length += ets_vsnprintf(dst->buffer + dst->length, dst->size - dst->length - 1, fmt, ap);
+	va_start(ap, fmt_flash);
+	string_vformat(dst, fmt_flash, ap);
 	va_end(ap);
+}
 
-	if(dst->length > (dst->size - 1))
-		dst->length = dst->size - 1;
+irom void string_format_data(string_t *dst, const char *fmt, ...)
+{
+	va_list ap;
 
-	dst->buffer[dst->length] = '\0';
+	va_start(ap, fmt);
+	string_vformat(dst, fmt, ap);
+	va_end(ap);
 }
 
 irom void string_cat_strptr(string_t *dst, const char *src)
@@ -193,67 +332,42 @@ irom void string_ip(string_t *dst, ip_addr_t addr)
 		ip_addr_to_bytes.byte[3]);
 }
 
-irom int string_double(string_t *dst, double value, int precision, double top_decimal)
+// value is scaled by 10^precision, e.g. 1234 with precision 2 is shown as 12.34
+
+irom int string_fixed(string_t *dst, int32_t value, int precision)
 {
-	double compare;
-	int decimal;
-	bool_t skip_leading_zeroes;
-	int original_length;
+	char digits[16];
+	char *digit;
+	unsigned int uvalue;
+	int length, original_length;
 
 	original_length = string_length(dst);
 
 	if(value < 0)
 	{
 		string_append(dst, '-');
-		value = 0 - value;
+		uvalue = 0 - (unsigned int)value;
 	}
+	else
+		uvalue = value;
 
-	skip_leading_zeroes = true;
+	if((precision < 0) || (precision > 10))
+		precision = 0;
 
-	if(value > (10 * top_decimal))
-	{
-		string_append(dst, '+');
-		string_append(dst, '+');
-		string_append(dst, '+');
+	digit = digits + sizeof(digits);
+	length = 0;
 
-		return(string_length(dst) - original_length);
-	}
-
-	for(compare = top_decimal; compare > 0; compare /= 10)
+	do
 	{
-		if(value >= compare)
-		{
-			skip_leading_zeroes = false;
-
-			decimal = (unsigned int)(value / compare);
-			value -= decimal * compare;
-
-			string_append(dst, (char)(decimal + '0'));
-		}
-		else
-			if(!skip_leading_zeroes)
-				string_append(dst, '0');
-
-		if((compare <= 1) && (precision == 0))
-			break;
-
-		if((unsigned int)compare == 1)
-		{
-			if(skip_leading_zeroes)
-			{
-				string_append(dst, '0');
-				skip_leading_zeroes = false;
-			}
-
-			string_append(dst, '.');
-		}
+		*--digit = (char)('0' + (uvalue % 10));
+		uvalue /= 10;
 
-		if((compare <= 1) && (precision > 0))
-			--precision;
-	}
+		if(++length == precision)
+			*--digit = '.';
+	} while(uvalue || (length <= precision));
 
-	if(string_length(dst) == original_length)
-		string_append(dst, '0');
+	for(; digit < (digits + sizeof(digits)); digit++)
+		string_append(dst, *digit);
 
 	return(string_length(dst) - original_length);
 }
@@ -402,6 +516,40 @@ irom void string_bin_to_hex(string_t *dst, const char *src, int length)
 	}
 }
 
+// returns the number of bytes, -1 on an odd length or a non hex digit
+
+irom int string_hex_to_bin(const string_t *src, int offset, int length, char *dst, int size)
+{
+	int ix, nibble;
+	char current;
+
+	if((length & 1) || ((length / 2) > size))
+		return(-1);
+
+	for(ix = 0; ix < length; ix++)
+	{
+		current = string_index(src, offset + ix);
+
+		if((current >= '0') && (current <= '9'))
+			nibble = current - '0';
+		else
+			if((current >= 'a') && (current <= 'f'))
+				nibble = (current - 'a') + 10;
+			else
+				if((current >= 'A') && (current <= 'F'))
+					nibble = (current - 'A') + 10;
+				else
+					return(-1);
+
+		if(ix & 1)
+			dst[ix / 2] |= nibble;
+		else
+			dst[ix / 2] = nibble << 4;
+	}
+
+	return(length / 2);
+}
+
 /**********************************************************************
  * Copyright (c) 2000 by Michael Barr.  This software is placed into
  * the public domain and may be used for any purpose.  However, this
@@ -409,43 +557,176 @@ irom void string_bin_to_hex(string_t *dst, const char *src, int length)
  * expressed or implied by its publication or distribution.
  **********************************************************************/
 
-static uint32_t string_crc_table[256];
+// crc32, polynomial 0x04c11db7, not reflected, tables for slice-by-4
 
-irom void string_crc32_init(void)
+static roflash const uint32_t string_crc_table[4][256] =
 {
-	unsigned int dividend, bit;
-	uint32_t remainder;
-
-	for(dividend = 0; dividend < (sizeof(string_crc_table) / sizeof(*string_crc_table)); dividend++)
 	{
-		remainder = dividend << (32 - 8);
-
-		for (bit = 8; bit > 0; --bit)
-		{
-			if (remainder & (1 << 31))
-				remainder = (remainder << 1) ^ 0x04c11db7;
-			else
-				remainder = (remainder << 1);
-		}
-
-		string_crc_table[dividend] = remainder;
+		0x00000000, 0x04c11db7, 0x09823b6e, 0x0d4326d9, 0x130476dc, 0x17c56b6b, 0x1a864db2, 0x1e475005,
+		0x2608edb8, 0x22c9f00f, 0x2f8ad6d6, 0x2b4bcb61, 0x350c9b64, 0x31cd86d3, 0x3c8ea00a, 0x384fbdbd,
+		0x4c11db70, 0x48d0c6c7, 0x4593e01e, 0x4152fda9, 0x5f15adac, 0x5bd4b01b, 0x569796c2, 0x52568b75,
+		0x6a1936c8, 0x6ed82b7f, 0x639b0da6, 0x675a1011, 0x791d4014, 0x7ddc5da3, 0x709f7b7a, 0x745e66cd,
+		0x9823b6e0, 0x9ce2ab57, 0x91a18d8e, 0x95609039, 0x8b27c03c, 0x8fe6dd8b, 0x82a5fb52, 0x8664e6e5,
+		0xbe2b5b58, 0xbaea46ef, 0xb7a96036, 0xb3687d81, 0xad2f2d84, 0xa9ee3033, 0xa4ad16ea, 0xa06c0b5d,
+		0xd4326d90, 0xd0f37027, 0xddb056fe, 0xd9714b49, 0xc7361b4c, 0xc3f706fb, 0xceb42022, 0xca753d95,
+		0xf23a8028, 0xf6fb9d9f, 0xfbb8bb46, 0xff79a6f1, 0xe13ef6f4, 0xe5ffeb43, 0xe8bccd9a, 0xec7dd02d,
+		0x34867077, 0x30476dc0, 0x3d044b19, 0x39c556ae, 0x278206ab, 0x23431b1c, 0x2e003dc5, 0x2ac12072,
+		0x128e9dcf, 0x164f8078, 0x1b0ca6a1, 0x1fcdbb16, 0x018aeb13, 0x054bf6a4, 0x0808d07d, 0x0cc9cdca,
+		0x7897ab07, 0x7c56b6b0, 0x71159069, 0x75d48dde, 0x6b93dddb, 0x6f52c06c, 0x6211e6b5, 0x66d0fb02,
+		0x5e9f46bf, 0x5a5e5b08, 0x571d7dd1, 0x53dc6066, 0x4d9b3063, 0x495a2dd4, 0x44190b0d, 0x40d816ba,
+		0xaca5c697, 0xa864db20, 0xa527fdf9, 0xa1e6e04e, 0xbfa1b04b, 0xbb60adfc, 0xb6238b25, 0xb2e29692,
+		0x8aad2b2f, 0x8e6c3698, 0x832f1041, 0x87ee0df6, 0x99a95df3, 0x9d684044, 0x902b669d, 0x94ea7b2a,
+		0xe0b41de7, 0xe4750050, 0xe9362689, 0xedf73b3e, 0xf3b06b3b, 0xf771768c, 0xfa325055, 0xfef34de2,
+		0xc6bcf05f, 0xc27dede8, 0xcf3ecb31, 0xcbffd686, 0xd5b88683, 0xd1799b34, 0xdc3abded, 0xd8fba05a,
+		0x690ce0ee, 0x6dcdfd59, 0x608edb80, 0x644fc637, 0x7a089632, 0x7ec98b85, 0x738aad5c, 0x774bb0eb,
+		0x4f040d56, 0x4bc510e1, 0x46863638, 0x42472b8f, 0x5c007b8a, 0x58c1663d, 0x558240e4, 0x51435d53,
+		0x251d3b9e, 0x21dc2629, 0x2c9f00f0, 0x285e1d47, 0x36194d42, 0x32d850f5, 0x3f9b762c, 0x3b5a6b9b,
+		0x0315d626, 0x07d4cb91, 0x0a97ed48, 0x0e56f0ff, 0x1011a0fa, 0x14d0bd4d, 0x19939b94, 0x1d528623,
+		0xf12f560e, 0xf5ee4bb9, 0xf8ad6d60, 0xfc6c70d7, 0xe22b20d2, 0xe6ea3d65, 0xeba91bbc, 0xef68060b,
+		0xd727bbb6, 0xd3e6a601, 0xdea580d8, 0xda649d6f, 0xc423cd6a, 0xc0e2d0dd, 0xcda1f604, 0xc960ebb3,
+		0xbd3e8d7e, 0xb9ff90c9, 0xb4bcb610, 0xb07daba7, 0xae3afba2, 0xaafbe615, 0xa7b8c0cc, 0xa379dd7b,
+		0x9b3660c6, 0x9ff77d71, 0x92b45ba8, 0x9675461f, 0x8832161a, 0x8cf30bad, 0x81b02d74, 0x857130c3,
+		0x5d8a9099, 0x594b8d2e, 0x5408abf7, 0x50c9b640, 0x4e8ee645, 0x4a4ffbf2, 0x470cdd2b, 0x43cdc09c,
+		0x7b827d21, 0x7f436096, 0x7200464f, 0x76c15bf8, 0x68860bfd, 0x6c47164a, 0x61043093, 0x65c52d24,
+		0x119b4be9, 0x155a565e, 0x18197087, 0x1cd86d30, 0x029f3d35, 0x065e2082, 0x0b1d065b, 0x0fdc1bec,
+		0x3793a651, 0x3352bbe6, 0x3e119d3f, 0x3ad08088, 0x2497d08d, 0x2056cd3a, 0x2d15ebe3, 0x29d4f654,
+		0xc5a92679, 0xc1683bce, 0xcc2b1d17, 0xc8ea00a0, 0xd6ad50a5, 0xd26c4d12, 0xdf2f6bcb, 0xdbee767c,
+		0xe3a1cbc1, 0xe760d676, 0xea23f0af, 0xeee2ed18, 0xf0a5bd1d, 0xf464a0aa, 0xf9278673, 0xfde69bc4,
+		0x89b8fd09, 0x8d79e0be, 0x803ac667, 0x84fbdbd0, 0x9abc8bd5, 0x9e7d9662, 0x933eb0bb, 0x97ffad0c,
+		0xafb010b1, 0xab710d06, 0xa6322bdf, 0xa2f33668, 0xbcb4666d, 0xb8757bda, 0xb5365d03, 0xb1f740b4
+	},
+	{
+		0x00000000, 0xd219c1dc, 0xa0f29e0f, 0x72eb5fd3, 0x452421a9, 0x973de075, 0xe5d6bfa6, 0x37cf7e7a,
+		0x8a484352, 0x5851828e, 0x2abadd5d, 0xf8a31c81, 0xcf6c62fb, 0x1d75a327, 0x6f9efcf4, 0xbd873d28,
+		0x10519b13, 0xc2485acf, 0xb0a3051c, 0x62bac4c0, 0x5575baba, 0x876c7b66, 0xf58724b5, 0x279ee569,
+		0x9a19d841, 0x4800199d, 0x3aeb464e, 0xe8f28792, 0xdf3df9e8, 0x0d243834, 0x7fcf67e7, 0xadd6a63b,
+		0x20a33626, 0xf2baf7fa, 0x8051a829, 0x524869f5, 0x6587178f, 0xb79ed653, 0xc5758980, 0x176c485c,
+		0xaaeb7574, 0x78f2b4a8, 0x0a19eb7b, 0xd8002aa7, 0xefcf54dd, 0x3dd69501, 0x4f3dcad2, 0x9d240b0e,
+		0x30f2ad35, 0xe2eb6ce9, 0x9000333a, 0x4219f2e6, 0x75d68c9c, 0xa7cf4d40, 0xd5241293, 0x073dd34f,
+		0xbabaee67, 0x68a32fbb, 0x1a487068, 0xc851b1b4, 0xff9ecfce, 0x2d870e12, 0x5f6c51c1, 0x8d75901d,
+		0x41466c4c, 0x935fad90, 0xe1b4f243, 0x33ad339f, 0x04624de5, 0xd67b8c39, 0xa490d3ea, 0x76891236,
+		0xcb0e2f1e, 0x1917eec2, 0x6bfcb111, 0xb9e570cd, 0x8e2a0eb7, 0x5c33cf6b, 0x2ed890b8, 0xfcc15164,
+		0x5117f75f, 0x830e3683, 0xf1e56950, 0x23fca88c, 0x1433d6f6, 0xc62a172a, 0xb4c148f9, 0x66d88925,
+		0xdb5fb40d, 0x094675d1, 0x7bad2a02, 0xa9b4ebde, 0x9e7b95a4, 0x4c625478, 0x3e890bab, 0xec90ca77,
+		0x61e55a6a, 0xb3fc9bb6, 0xc117c465, 0x130e05b9, 0x24c17bc3, 0xf6d8ba1f, 0x8433e5cc, 0x562a2410,
+		0xebad1938, 0x39b4d8e4, 0x4b5f8737, 0x994646eb, 0xae893891, 0x7c90f94d, 0x0e7ba69e, 0xdc626742,
+		0x71b4c179, 0xa3ad00a5, 0xd1465f76, 0x035f9eaa, 0x3490e0d0, 0xe689210c, 0x94627edf, 0x467bbf03,
+		0xfbfc822b, 0x29e543f7, 0x5b0e1c24, 0x8917ddf8, 0xbed8a382, 0x6cc1625e, 0x1e2a3d8d, 0xcc33fc51,
+		0x828cd898, 0x50951944, 0x227e4697, 0xf067874b, 0xc7a8f931, 0x15b138ed, 0x675a673e, 0xb543a6e2,
+		0x08c49bca, 0xdadd5a16, 0xa83605c5, 0x7a2fc419, 0x4de0ba63, 0x9ff97bbf, 0xed12246c, 0x3f0be5b0,
+		0x92dd438b, 0x40c48257, 0x322fdd84, 0xe0361c58, 0xd7f96222, 0x05e0a3fe, 0x770bfc2d, 0xa5123df1,
+		0x189500d9, 0xca8cc105, 0xb8679ed6, 0x6a7e5f0a, 0x5db12170, 0x8fa8e0ac, 0xfd43bf7f, 0x2f5a7ea3,
+		0xa22feebe, 0x70362f62, 0x02dd70b1, 0xd0c4b16d, 0xe70bcf17, 0x35120ecb, 0x47f95118, 0x95e090c4,
+		0x2867adec, 0xfa7e6c30, 0x889533e3, 0x5a8cf23f, 0x6d438c45, 0xbf5a4d99, 0xcdb1124a, 0x1fa8d396,
+		0xb27e75ad, 0x6067b471, 0x128ceba2, 0xc0952a7e, 0xf75a5404, 0x254395d8, 0x57a8ca0b, 0x85b10bd7,
+		0x383636ff, 0xea2ff723, 0x98c4a8f0, 0x4add692c, 0x7d121756, 0xaf0bd68a, 0xdde08959, 0x0ff94885,
+		0xc3cab4d4, 0x11d37508, 0x63382adb, 0xb121eb07, 0x86ee957d, 0x54f754a1, 0x261c0b72, 0xf405caae,
+		0x4982f786, 0x9b9b365a, 0xe9706989, 0x3b69a855, 0x0ca6d62f, 0xdebf17f3, 0xac544820, 0x7e4d89fc,
+		0xd39b2fc7, 0x0182ee1b, 0x7369b1c8, 0xa1707014, 0x96bf0e6e, 0x44a6cfb2, 0x364d9061, 0xe45451bd,
+		0x59d36c95, 0x8bcaad49, 0xf921f29a, 0x2b383346, 0x1cf74d3c, 0xceee8ce0, 0xbc05d333, 0x6e1c12ef,
+		0xe36982f2, 0x3170432e, 0x439b1cfd, 0x9182dd21, 0xa64da35b, 0x74546287, 0x06bf3d54, 0xd4a6fc88,
+		0x6921c1a0, 0xbb38007c, 0xc9d35faf, 0x1bca9e73, 0x2c05e009, 0xfe1c21d5, 0x8cf77e06, 0x5eeebfda,
+		0xf33819e1, 0x2121d83d, 0x53ca87ee, 0x81d34632, 0xb61c3848, 0x6405f994, 0x16eea647, 0xc4f7679b,
+		0x79705ab3, 0xab699b6f, 0xd982c4bc, 0x0b9b0560, 0x3c547b1a, 0xee4dbac6, 0x9ca6e515, 0x4ebf24c9
+	},
+	{
+		0x00000000, 0x01d8ac87, 0x03b1590e, 0x0269f589, 0x0762b21c, 0x06ba1e9b, 0x04d3eb12, 0x050b4795,
+		0x0ec56438, 0x0f1dc8bf, 0x0d743d36, 0x0cac91b1, 0x09a7d624, 0x087f7aa3, 0x0a168f2a, 0x0bce23ad,
+		0x1d8ac870, 0x1c5264f7, 0x1e3b917e, 0x1fe33df9, 0x1ae87a6c, 0x1b30d6eb, 0x19592362, 0x18818fe5,
+		0x134fac48, 0x129700cf, 0x10fef546, 0x112659c1, 0x142d1e54, 0x15f5b2d3, 0x179c475a, 0x1644ebdd,
+		0x3b1590e0, 0x3acd3c67, 0x38a4c9ee, 0x397c6569, 0x3c7722fc, 0x3daf8e7b, 0x3fc67bf2, 0x3e1ed775,
+		0x35d0f4d8, 0x3408585f, 0x3661add6, 0x37b90151, 0x32b246c4, 0x336aea43, 0x31031fca, 0x30dbb34d,
+		0x269f5890, 0x2747f417, 0x252e019e, 0x24f6ad19, 0x21fdea8c, 0x2025460b, 0x224cb382, 0x23941f05,
+		0x285a3ca8, 0x2982902f, 0x2beb65a6, 0x2a33c921, 0x2f388eb4, 0x2ee02233, 0x2c89d7ba, 0x2d517b3d,
+		0x762b21c0, 0x77f38d47, 0x759a78ce, 0x7442d449, 0x714993dc, 0x70913f5b, 0x72f8cad2, 0x73206655,
+		0x78ee45f8, 0x7936e97f, 0x7b5f1cf6, 0x7a87b071, 0x7f8cf7e4, 0x7e545b63, 0x7c3daeea, 0x7de5026d,
+		0x6ba1e9b0, 0x6a794537, 0x6810b0be, 0x69c81c39, 0x6cc35bac, 0x6d1bf72b, 0x6f7202a2, 0x6eaaae25,
+		0x65648d88, 0x64bc210f, 0x66d5d486, 0x670d7801, 0x62063f94, 0x63de9313, 0x61b7669a, 0x606fca1d,
+		0x4d3eb120, 0x4ce61da7, 0x4e8fe82e, 0x4f5744a9, 0x4a5c033c, 0x4b84afbb, 0x49ed5a32, 0x4835f6b5,
+		0x43fbd518, 0x4223799f, 0x404a8c16, 0x41922091, 0x44996704, 0x4541cb83, 0x47283e0a, 0x46f0928d,
+		0x50b47950, 0x516cd5d7, 0x5305205e, 0x52dd8cd9, 0x57d6cb4c, 0x560e67cb, 0x54679242, 0x55bf3ec5,
+		0x5e711d68, 0x5fa9b1ef, 0x5dc04466, 0x5c18e8e1, 0x5913af74, 0x58cb03f3, 0x5aa2f67a, 0x5b7a5afd,
+		0xec564380, 0xed8eef07, 0xefe71a8e, 0xee3fb609, 0xeb34f19c, 0xeaec5d1b, 0xe885a892, 0xe95d0415,
+		0xe29327b8, 0xe34b8b3f, 0xe1227eb6, 0xe0fad231, 0xe5f195a4, 0xe4293923, 0xe640ccaa, 0xe798602d,
+		0xf1dc8bf0, 0xf0042777, 0xf26dd2fe, 0xf3b57e79, 0xf6be39ec, 0xf766956b, 0xf50f60e2, 0xf4d7cc65,
+		0xff19efc8, 0xfec1434f, 0xfca8b6c6, 0xfd701a41, 0xf87b5dd4, 0xf9a3f153, 0xfbca04da, 0xfa12a85d,
+		0xd743d360, 0xd69b7fe7, 0xd4f28a6e, 0xd52a26e9, 0xd021617c, 0xd1f9cdfb, 0xd3903872, 0xd24894f5,
+		0xd986b758, 0xd85e1bdf, 0xda37ee56, 0xdbef42d1, 0xdee40544, 0xdf3ca9c3, 0xdd555c4a, 0xdc8df0cd,
+		0xcac91b10, 0xcb11b797, 0xc978421e, 0xc8a0ee99, 0xcdaba90c, 0xcc73058b, 0xce1af002, 0xcfc25c85,
+		0xc40c7f28, 0xc5d4d3af, 0xc7bd2626, 0xc6658aa1, 0xc36ecd34, 0xc2b661b3, 0xc0df943a, 0xc10738bd,
+		0x9a7d6240, 0x9ba5cec7, 0x99cc3b4e, 0x981497c9, 0x9d1fd05c, 0x9cc77cdb, 0x9eae8952, 0x9f7625d5,
+		0x94b80678, 0x9560aaff, 0x97095f76, 0x96d1f3f1, 0x93dab464, 0x920218e3, 0x906bed6a, 0x91b341ed,
+		0x87f7aa30, 0x862f06b7, 0x8446f33e, 0x859e5fb9, 0x8095182c, 0x814db4ab, 0x83244122, 0x82fceda5,
+		0x8932ce08, 0x88ea628f, 0x8a839706, 0x8b5b3b81, 0x8e507c14, 0x8f88d093, 0x8de1251a, 0x8c39899d,
+		0xa168f2a0, 0xa0b05e27, 0xa2d9abae, 0xa3010729, 0xa60a40bc, 0xa7d2ec3b, 0xa5bb19b2, 0xa463b535,
+		0xafad9698, 0xae753a1f, 0xac1ccf96, 0xadc46311, 0xa8cf2484, 0xa9178803, 0xab7e7d8a, 0xaaa6d10d,
+		0xbce23ad0, 0xbd3a9657, 0xbf5363de, 0xbe8bcf59, 0xbb8088cc, 0xba58244b, 0xb831d1c2, 0xb9e97d45,
+		0xb2275ee8, 0xb3fff26f, 0xb19607e6, 0xb04eab61, 0xb545ecf4, 0xb49d4073, 0xb6f4b5fa, 0xb72c197d
+	},
+	{
+		0x00000000, 0xdc6d9ab7, 0xbc1a28d9, 0x6077b26e, 0x7cf54c05, 0xa098d6b2, 0xc0ef64dc, 0x1c82fe6b,
+		0xf9ea980a, 0x258702bd, 0x45f0b0d3, 0x999d2a64, 0x851fd40f, 0x59724eb8, 0x3905fcd6, 0xe5686661,
+		0xf7142da3, 0x2b79b714, 0x4b0e057a, 0x97639fcd, 0x8be161a6, 0x578cfb11, 0x37fb497f, 0xeb96d3c8,
+		0x0efeb5a9, 0xd2932f1e, 0xb2e49d70, 0x6e8907c7, 0x720bf9ac, 0xae66631b, 0xce11d175, 0x127c4bc2,
+		0xeae946f1, 0x3684dc46, 0x56f36e28, 0x8a9ef49f, 0x961c0af4, 0x4a719043, 0x2a06222d, 0xf66bb89a,
+		0x1303defb, 0xcf6e444c, 0xaf19f622, 0x73746c95, 0x6ff692fe, 0xb39b0849, 0xd3ecba27, 0x0f812090,
+		0x1dfd6b52, 0xc190f1e5, 0xa1e7438b, 0x7d8ad93c, 0x61082757, 0xbd65bde0, 0xdd120f8e, 0x017f9539,
+		0xe417f358, 0x387a69ef, 0x580ddb81, 0x84604136, 0x98e2bf5d, 0x448f25ea, 0x24f89784, 0xf8950d33,
+		0xd1139055, 0x0d7e0ae2, 0x6d09b88c, 0xb164223b, 0xade6dc50, 0x718b46e7, 0x11fcf489, 0xcd916e3e,
+		0x28f9085f, 0xf49492e8, 0x94e32086, 0x488eba31, 0x540c445a, 0x8861deed, 0xe8166c83, 0x347bf634,
+		0x2607bdf6, 0xfa6a2741, 0x9a1d952f, 0x46700f98, 0x5af2f1f3, 0x869f6b44, 0xe6e8d92a, 0x3a85439d,
+		0xdfed25fc, 0x0380bf4b, 0x63f70d25, 0xbf9a9792, 0xa31869f9, 0x7f75f34e, 0x1f024120, 0xc36fdb97,
+		0x3bfad6a4, 0xe7974c13, 0x87e0fe7d, 0x5b8d64ca, 0x470f9aa1, 0x9b620016, 0xfb15b278, 0x277828cf,
+		0xc2104eae, 0x1e7dd419, 0x7e0a6677, 0xa267fcc0, 0xbee502ab, 0x6288981c, 0x02ff2a72, 0xde92b0c5,
+		0xcceefb07, 0x108361b0, 0x70f4d3de, 0xac994969, 0xb01bb702, 0x6c762db5, 0x0c019fdb, 0xd06c056c,
+		0x3504630d, 0xe969f9ba, 0x891e4bd4, 0x5573d163, 0x49f12f08, 0x959cb5bf, 0xf5eb07d1, 0x29869d66,
+		0xa6e63d1d, 0x7a8ba7aa, 0x1afc15c4, 0xc6918f73, 0xda137118, 0x067eebaf, 0x660959c1, 0xba64c376,
+		0x5f0ca517, 0x83613fa0, 0xe3168dce, 0x3f7b1779, 0x23f9e912, 0xff9473a5, 0x9fe3c1cb, 0x438e5b7c,
+		0x51f210be, 0x8d9f8a09, 0xede83867, 0x3185a2d0, 0x2d075cbb, 0xf16ac60c, 0x911d7462, 0x4d70eed5,
+		0xa81888b4, 0x74751203, 0x1402a06d, 0xc86f3ada, 0xd4edc4b1, 0x08805e06, 0x68f7ec68, 0xb49a76df,
+		0x4c0f7bec, 0x9062e15b, 0xf0155335, 0x2c78c982, 0x30fa37e9, 0xec97ad5e, 0x8ce01f30, 0x508d8587,
+		0xb5e5e3e6, 0x69887951, 0x09ffcb3f, 0xd5925188, 0xc910afe3, 0x157d3554, 0x750a873a, 0xa9671d8d,
+		0xbb1b564f, 0x6776ccf8, 0x07017e96, 0xdb6ce421, 0xc7ee1a4a, 0x1b8380fd, 0x7bf43293, 0xa799a824,
+		0x42f1ce45, 0x9e9c54f2, 0xfeebe69c, 0x22867c2b, 0x3e048240, 0xe26918f7, 0x821eaa99, 0x5e73302e,
+		0x77f5ad48, 0xab9837ff, 0xcbef8591, 0x17821f26, 0x0b00e14d, 0xd76d7bfa, 0xb71ac994, 0x6b775323,
+		0x8e1f3542, 0x5272aff5, 0x32051d9b, 0xee68872c, 0xf2ea7947, 0x2e87e3f0, 0x4ef0519e, 0x929dcb29,
+		0x80e180eb, 0x5c8c1a5c, 0x3cfba832, 0xe0963285, 0xfc14ccee, 0x20795659, 0x400ee437, 0x9c637e80,
+		0x790b18e1, 0xa5668256, 0xc5113038, 0x197caa8f, 0x05fe54e4, 0xd993ce53, 0xb9e47c3d, 0x6589e68a,
+		0x9d1cebb9, 0x4171710e, 0x2106c360, 0xfd6b59d7, 0xe1e9a7bc, 0x3d843d0b, 0x5df38f65, 0x819e15d2,
+		0x64f673b3, 0xb89be904, 0xd8ec5b6a, 0x0481c1dd, 0x18033fb6, 0xc46ea501, 0xa419176f, 0x78748dd8,
+		0x6a08c61a, 0xb6655cad, 0xd612eec3, 0x0a7f7474, 0x16fd8a1f, 0xca9010a8, 0xaae7a2c6, 0x768a3871,
+		0x93e25e10, 0x4f8fc4a7, 0x2ff876c9, 0xf395ec7e, 0xef171215, 0x337a88a2, 0x530d3acc, 0x8f60a07b
 	}
-}
+};
 
 irom attr_pure uint32_t string_crc32(const string_t *src, int offset, int length)
 {
 	uint32_t remainder = 0xffffffff;
-	uint8_t data;
-	int src_length;
+	const uint8_t *data;
+	uint32_t word;
 
-	src_length = string_length(src);
+	if(offset < 0)
+		offset = 0;
 
-	for(; (length > 0) && (offset < src_length); offset++, length--)
+	if(length > (string_length(src) - offset))
+		length = string_length(src) - offset;
+
+	data = (const uint8_t *)src->buffer + offset;
+
+	for(; (length > 0) && ((uintptr_t)data & 3); data++, length--)
+		remainder = string_crc_table[0][*data ^ (remainder >> 24)] ^ (remainder << 8);
+
+	for(; length >= 4; data += 4, length -= 4)
 	{
-		data = string_index(src, offset) ^ (remainder >> (32 - 8));
-		remainder = string_crc_table[data] ^ (remainder << 8);
+		word = *(const uint32_t *)(const void *)data;
+		remainder ^= __builtin_bswap32(word);
+		remainder = string_crc_table[3][remainder >> 24] ^ string_crc_table[2][(remainder >> 16) & 0xff] ^
+				string_crc_table[1][(remainder >> 8) & 0xff] ^ string_crc_table[0][remainder & 0xff];
 	}
 
+	for(; length > 0; data++, length--)
+		remainder = string_crc_table[0][*data ^ (remainder >> 24)] ^ (remainder << 8);
+
 	return(remainder ^ 0xffffffff);
 }
 
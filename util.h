@@ -156,7 +156,7 @@ do { \
 void string_cat_strptr(string_t *dst, const char *src);
 int string_copy_string(string_t *dst, string_t *src);
 void string_ip(string_t *dst, ip_addr_t);
-int string_double(string_t *dst, double value, int precision, double top_decimal);
+int string_fixed(string_t *dst, int32_t value, int precision);
 static inline int string_length(const string_t *dst) { return(dst->length); }
 static inline int string_size(const string_t *dst) { return(dst->size - 1); }
 static inline bool_t string_space(const string_t *dst) { return(string_length(dst) < string_size(dst)); }
@@ -175,7 +175,7 @@ int string_find(const string_t *, int offset, char c);
 void string_replace(string_t *, int index, char c);
 void string_splice(string_t *dst, const string_t *src, int src_offset, int length);
 void string_bin_to_hex(string_t *dst, const char *src, int length);
-void string_crc32_init(void);
+int string_hex_to_bin(const string_t *src, int offset, int length, char *dst, int size);
 uint32_t string_crc32(const string_t *src, int offset, int length);
 
 parse_error_t parse_string(int index, const string_t *in, string_t *out);